@@ -0,0 +1,365 @@
+// MatchingEngine microbenchmarks: synthetic order flow straight through
+// new_limit_order / new_market_order / cancel, no sockets or threads.
+//
+//   make bench_engine && ./build/bench_engine [ops=1000000] [seed=42]
+//        [scenario=all|passive|sweep|xsweep|mm|deep] [json=results.json] [label=<text>]
+//
+// Every scenario runs twice on a fresh engine: once untimed per call for
+// throughput, once with a clock read around each call for the latency
+// histograms (per operation kind). The clock's own cost is reported as
+// timer_ns and included in the latencies. json= writes the numbers in a
+// stable layout for comparing builds; label= tags the run (e.g. a git rev).
+#include "common/latency_histogram.hpp"
+#include "engine/matching_engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ts;
+
+namespace {
+
+// Cross is a limit order priced through the book: the same call as Add,
+// reported apart so matching is not averaged with resting
+enum class OpKind : uint8_t { Add, Market, Cancel, Cross };
+constexpr int kKinds = 4;
+const char* const kKindNames[kKinds] = {"add", "market", "cancel", "cross"};
+
+struct Op {
+  OpKind kind;
+  Side side;
+  int qty;
+  double px;
+  uint64_t cancel_id;
+};
+
+struct Scenario {
+  const char* name;
+  const char* about;
+  std::vector<Op> setup;  // applied untimed before the run
+  std::vector<Op> ops;
+};
+
+// Builds op streams while predicting engine ids: every new_*_order call
+// takes the next id, whether it rests or not.
+class FlowBuilder {
+public:
+  explicit FlowBuilder(uint32_t seed) : rng_(seed) {}
+
+  uint64_t add(std::vector<Op>& out, Side side, int qty, long ticks) {
+    out.push_back(Op{OpKind::Add, side, qty, static_cast<double>(ticks) / 100.0, 0});
+    return next_id_++;
+  }
+  void cross(std::vector<Op>& out, Side side, int qty, long ticks) {
+    out.push_back(Op{OpKind::Cross, side, qty, static_cast<double>(ticks) / 100.0, 0});
+    ++next_id_;
+  }
+  void market(std::vector<Op>& out, Side side, int qty) {
+    out.push_back(Op{OpKind::Market, side, qty, 0, 0});
+    ++next_id_;
+  }
+  void cancel(std::vector<Op>& out, uint64_t id) { out.push_back(Op{OpKind::Cancel, Side::Buy, 0, 0, id}); }
+
+  int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng_); }
+  Side side() { return uniform(0, 1) ? Side::Buy : Side::Sell; }
+
+private:
+  std::mt19937 rng_;
+  uint64_t next_id_{1};
+};
+
+constexpr long kMid = 10000;  // ticks of 0.01
+
+// Orders resting near the touch that never cross: pure insertion cost.
+Scenario passive(size_t n, uint32_t seed) {
+  Scenario s{"passive", "non-crossing adds within 50 ticks of mid", {}, {}};
+  FlowBuilder f(seed);
+  s.ops.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    Side side = f.side();
+    long off = f.uniform(1, 50);
+    f.add(s.ops, side, f.uniform(1, 10), side == Side::Buy ? kMid - off : kMid + off);
+  }
+  return s;
+}
+
+// Refill a few levels, then sweep them with one market order.
+Scenario sweep(size_t n, uint32_t seed) {
+  Scenario s{"sweep", "replenish 8 levels, then a market order through them", {}, {}};
+  FlowBuilder f(seed);
+  s.ops.reserve(n);
+  while (s.ops.size() < n) {
+    Side maker = f.side();
+    int total = 0;
+    for (int lvl = 1; lvl <= 8 && s.ops.size() < n; ++lvl) {
+      int q = f.uniform(1, 10);
+      total += q;
+      f.add(s.ops, maker, q, maker == Side::Buy ? kMid - lvl : kMid + lvl);
+    }
+    if (s.ops.size() < n) f.market(s.ops, maker == Side::Buy ? Side::Sell : Side::Buy, total);
+  }
+  return s;
+}
+
+// Many small orders over 16 levels, taken by a limit order through 12 of
+// them and a market order for the rest: each taker fills ~48 makers, so
+// the matching loop itself dominates.
+Scenario xsweep(size_t n, uint32_t seed) {
+  Scenario s{"xsweep", "4 orders x 16 levels, swept by a crossing limit (12 levels) + market", {}, {}};
+  FlowBuilder f(seed);
+  s.ops.reserve(n + 80);
+  while (s.ops.size() < n) {
+    Side maker = f.side();
+    Side taker = maker == Side::Buy ? Side::Sell : Side::Buy;
+    int near = 0, rest = 0;
+    for (long lvl = 1; lvl <= 16; ++lvl) {
+      for (int k = 0; k < 4; ++k) {
+        int q = f.uniform(1, 3);
+        (lvl <= 12 ? near : rest) += q;
+        f.add(s.ops, maker, q, maker == Side::Buy ? kMid - lvl : kMid + lvl);
+      }
+    }
+    f.cross(s.ops, taker, near, maker == Side::Buy ? kMid - 12 : kMid + 12);
+    f.market(s.ops, taker, rest);
+  }
+  return s;
+}
+
+// A market maker re-quoting a ladder around a drifting mid: mostly cancel +
+// replace, with the odd crossing order from someone else.
+Scenario mm(size_t n, uint32_t seed) {
+  Scenario s{"mm", "cancel/replace quotes around a random-walk mid, 5% crossing", {}, {}};
+  FlowBuilder f(seed);
+  constexpr size_t kQuotes = 64;  // live quotes per side
+  std::vector<uint64_t> bids(kQuotes), asks(kQuotes);
+  size_t head = 0;
+  long mid = kMid;
+  for (size_t i = 0; i < kQuotes; ++i) {
+    bids[i] = f.add(s.setup, Side::Buy, 5, mid - 1 - static_cast<long>(i % 16));
+    asks[i] = f.add(s.setup, Side::Sell, 5, mid + 1 + static_cast<long>(i % 16));
+  }
+  s.ops.reserve(n);
+  while (s.ops.size() < n) {
+    if (f.uniform(0, 15) == 0) mid += f.uniform(-1, 1);
+    if (f.uniform(0, 19) == 0) {
+      Side side = f.side();
+      f.add(s.ops, side, f.uniform(1, 10), side == Side::Buy ? mid + 1 : mid - 1);
+      continue;
+    }
+    // replace the oldest quote on one side
+    bool buy = f.uniform(0, 1) != 0;
+    auto& q = buy ? bids : asks;
+    f.cancel(s.ops, q[head % kQuotes]);
+    long off = f.uniform(1, 16);
+    q[head % kQuotes] = f.add(s.ops, buy ? Side::Buy : Side::Sell, 5, buy ? mid - off : mid + off);
+    ++head;
+  }
+  s.ops.resize(n);
+  return s;
+}
+
+// A wide book (beyond the ladder window on both sides) with many orders
+// per level: random adds, cancels of random resting orders, small sweeps.
+Scenario deep(size_t n, uint32_t seed) {
+  Scenario s{"deep", "20000 levels x 5 orders per side; random adds, cancels, small sweeps", {}, {}};
+  FlowBuilder f(seed);
+  constexpr long kLevels = 20000;
+  std::vector<uint64_t> live;
+  live.reserve(2 * kLevels * 5 + n);
+  for (long lvl = 1; lvl <= kLevels; ++lvl) {
+    for (int k = 0; k < 5; ++k) {
+      live.push_back(f.add(s.setup, Side::Buy, 10, kMid - lvl));
+      live.push_back(f.add(s.setup, Side::Sell, 10, kMid + lvl));
+    }
+  }
+  s.ops.reserve(n);
+  while (s.ops.size() < n) {
+    int r = f.uniform(0, 99);
+    if (r < 45) {
+      Side side = f.side();
+      long off = f.uniform(1, static_cast<int>(kLevels));
+      live.push_back(f.add(s.ops, side, f.uniform(1, 10), side == Side::Buy ? kMid - off : kMid + off));
+    } else if (r < 95) {
+      size_t k = static_cast<size_t>(f.uniform(0, static_cast<int>(live.size()) - 1));
+      f.cancel(s.ops, live[k]);
+      live[k] = live.back();
+      live.pop_back();
+    } else {
+      f.market(s.ops, f.side(), f.uniform(10, 60));
+    }
+  }
+  return s;
+}
+
+struct Result {
+  const Scenario* sc;
+  size_t fills{0};
+  double seconds{0};
+  LatencyHistogram hist[kKinds];
+};
+
+inline void apply(MatchingEngine& eng, const Op& op, std::vector<Trade>& fills) {
+  switch (op.kind) {
+    case OpKind::Add:
+    case OpKind::Cross: eng.new_limit_order(ClientId{1}, op.side, op.qty, op.px, fills); break;
+    case OpKind::Market: eng.new_market_order(ClientId{2}, op.side, op.qty, fills); break;
+    case OpKind::Cancel: fills.clear(); (void)eng.cancel(op.cancel_id); break;
+  }
+}
+
+void prepare(MatchingEngine& eng, const Scenario& sc, std::vector<Trade>& fills) {
+  for (const Op& op : sc.setup) apply(eng, op, fills);
+}
+
+void run(const Scenario& sc, Result& res) {
+  using clock = std::chrono::steady_clock;
+  std::vector<Trade> fills;
+  fills.reserve(256);
+  {
+    MatchingEngine eng;
+    prepare(eng, sc, fills);
+    auto t0 = clock::now();
+    for (const Op& op : sc.ops) {
+      apply(eng, op, fills);
+      res.fills += fills.size();
+    }
+    res.seconds = std::chrono::duration<double>(clock::now() - t0).count();
+  }
+  MatchingEngine eng;
+  prepare(eng, sc, fills);
+  for (const Op& op : sc.ops) {
+    auto t0 = clock::now();
+    apply(eng, op, fills);
+    auto t1 = clock::now();
+    res.hist[static_cast<int>(op.kind)].record(
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+  }
+}
+
+// median cost of two back-to-back clock reads
+uint64_t timer_overhead() {
+  using clock = std::chrono::steady_clock;
+  LatencyHistogram h;
+  for (int i = 0; i < 100000; ++i) {
+    auto t0 = clock::now();
+    auto t1 = clock::now();
+    h.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+  }
+  return h.percentile(0.5);
+}
+
+void print(const Result& r) {
+  const Scenario& sc = *r.sc;
+  std::printf("[%s] %s\n", sc.name, sc.about);
+  std::printf("  %zu ops in %.3f s = %.2f Mops/s, fills=%zu\n", sc.ops.size(), r.seconds,
+              static_cast<double>(sc.ops.size()) / r.seconds / 1e6, r.fills);
+  std::printf("  %-7s %10s %8s %8s %8s %8s %10s\n", "op", "count", "mean", "p50", "p99", "p99.9", "max (ns)");
+  for (int k = 0; k < kKinds; ++k) {
+    const LatencyHistogram& h = r.hist[k];
+    if (h.count() == 0) continue;
+    std::printf("  %-7s %10llu %8.1f %8llu %8llu %8llu %10llu\n", kKindNames[k],
+                static_cast<unsigned long long>(h.count()), h.mean(),
+                static_cast<unsigned long long>(h.percentile(0.50)),
+                static_cast<unsigned long long>(h.percentile(0.99)),
+                static_cast<unsigned long long>(h.percentile(0.999)),
+                static_cast<unsigned long long>(h.max()));
+  }
+}
+
+std::string json_escape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20) out += c;
+  }
+  return out;
+}
+
+bool write_json(const std::string& path, const std::string& label, size_t n, uint32_t seed, uint64_t timer_ns,
+                const std::vector<Result>& results) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fprintf(f, "{\n  \"benchmark\": \"bench_engine\",\n  \"format\": 1,\n");
+  std::fprintf(f, "  \"label\": \"%s\",\n  \"ops\": %zu,\n  \"seed\": %u,\n  \"timer_ns\": %llu,\n",
+               json_escape(label).c_str(), n, seed, static_cast<unsigned long long>(timer_ns));
+  std::fprintf(f, "  \"scenarios\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    std::fprintf(f, "%s\n    {\"name\": \"%s\", \"ops\": %zu, \"fills\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.0f,\n",
+                 i ? "," : "", r.sc->name, r.sc->ops.size(), r.fills, r.seconds,
+                 static_cast<double>(r.sc->ops.size()) / r.seconds);
+    std::fprintf(f, "     \"latency_ns\": {");
+    bool first = true;
+    for (int k = 0; k < kKinds; ++k) {
+      const LatencyHistogram& h = r.hist[k];
+      if (h.count() == 0) continue;
+      std::fprintf(f, "%s\n       \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, "
+                      "\"p99\": %llu, \"p99.9\": %llu, \"max\": %llu}",
+                   first ? "" : ",", kKindNames[k], static_cast<unsigned long long>(h.count()), h.mean(),
+                   static_cast<unsigned long long>(h.percentile(0.50)),
+                   static_cast<unsigned long long>(h.percentile(0.90)),
+                   static_cast<unsigned long long>(h.percentile(0.99)),
+                   static_cast<unsigned long long>(h.percentile(0.999)),
+                   static_cast<unsigned long long>(h.max()));
+      first = false;
+    }
+    std::fprintf(f, "}}");
+  }
+  std::fprintf(f, "\n  ]\n}\n");
+  return std::fclose(f) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t n = 1000000;
+  uint32_t seed = 42;
+  std::string which = "all", json, label;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto eq = arg.find('=');
+      std::string key = arg.substr(0, eq), val = eq == std::string::npos ? "" : arg.substr(eq + 1);
+      if (key == "ops") n = std::stoul(val);
+      else if (key == "seed") seed = static_cast<uint32_t>(std::stoul(val));
+      else if (key == "scenario") which = val;
+      else if (key == "json") json = val;
+      else if (key == "label") label = val;
+      else throw std::invalid_argument(arg);
+    }
+  } catch (...) {
+    std::fprintf(stderr, "usage: bench_engine [ops=N] [seed=N] [scenario=all|passive|sweep|xsweep|mm|deep] "
+                         "[json=path] [label=text]\n");
+    return 1;
+  }
+
+  using Factory = Scenario (*)(size_t, uint32_t);
+  const std::pair<const char*, Factory> all[] = {{"passive", passive}, {"sweep", sweep}, {"xsweep", xsweep}, {"mm", mm}, {"deep", deep}};
+  std::vector<Scenario> scenarios;
+  for (const auto& [name, make] : all) {
+    if (which == "all" || which == name) scenarios.push_back(make(n, seed));
+  }
+  if (scenarios.empty()) {
+    std::fprintf(stderr, "unknown scenario %s\n", which.c_str());
+    return 1;
+  }
+
+  uint64_t timer_ns = timer_overhead();
+  std::printf("ops=%zu seed=%u timer_ns=%llu\n", n, seed, static_cast<unsigned long long>(timer_ns));
+  std::vector<Result> results(scenarios.size());
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    results[i].sc = &scenarios[i];
+    run(scenarios[i], results[i]);
+    print(results[i]);
+  }
+  if (!json.empty() && !write_json(json, label, n, seed, timer_ns, results)) {
+    std::fprintf(stderr, "cannot write %s\n", json.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+// Compares the tick-ladder MatchingEngine against the previous
+// std::map<double, std::deque<Order>> book on identical synthetic flow.
+//
+//   make bench_ladder && ./build/bench_ladder [orders=2000000] [seed=42]
+#include "engine/matching_engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace ts;
+
+namespace {
+
+// The pre-ladder engine, kept verbatim in behaviour as the baseline.
+class MapBookEngine {
+public:
+  struct MapOrder { uint64_t id; std::string client; Side side; int qty; double px; };
+  struct MapTrade { uint64_t maker_id, taker_id; int qty; double px; std::string maker_client, taker_client; };
+
+  std::vector<MapTrade> new_limit_order(const std::string& client, Side side, int qty, double px) {
+    MapOrder taker{next_id_++, client, side, qty, px};
+    auto fills = match_incoming(taker);
+    if (taker.qty > 0) {
+      if (side == Side::Buy) bids_[px].push_back(taker);
+      else                   asks_[px].push_back(taker);
+    }
+    return fills;
+  }
+
+  bool cancel(uint64_t id) { return cancel_in(bids_, id) || cancel_in(asks_, id); }
+
+private:
+  uint64_t next_id_{1};
+  std::map<double, std::deque<MapOrder>, std::greater<double>> bids_;
+  std::map<double, std::deque<MapOrder>, std::less<double>> asks_;
+
+  template <class Book>
+  static bool cancel_in(Book& book, uint64_t id) {
+    for (auto it = book.begin(); it != book.end(); ++it) {
+      auto& dq = it->second;
+      for (auto dit = dq.begin(); dit != dq.end(); ++dit) {
+        if (dit->id == id) { dq.erase(dit); if (dq.empty()) book.erase(it); return true; }
+      }
+    }
+    return false;
+  }
+
+  template <class Book, class Cross>
+  static void sweep(Book& book, MapOrder& taker, Cross stop, std::vector<MapTrade>& fills) {
+    while (taker.qty > 0 && !book.empty()) {
+      auto it = book.begin();
+      if (stop(it->first)) break;
+      auto& q = it->second;
+      MapOrder& maker = q.front();
+      int qty = std::min(taker.qty, maker.qty);
+      taker.qty -= qty; maker.qty -= qty;
+      fills.push_back({maker.id, taker.id, qty, it->first, maker.client, taker.client});
+      if (maker.qty == 0) { q.pop_front(); if (q.empty()) book.erase(it); }
+    }
+  }
+
+  std::vector<MapTrade> match_incoming(MapOrder& taker) {
+    std::vector<MapTrade> fills;
+    if (taker.side == Side::Buy) sweep(asks_, taker, [&](double p) { return p > taker.px; }, fills);
+    else                         sweep(bids_, taker, [&](double p) { return p < taker.px; }, fills);
+    return fills;
+  }
+};
+
+struct Op {
+  bool cancel;
+  Side side;
+  int qty;
+  double px;
+  uint64_t cancel_id;
+};
+
+// Passive quotes around a random-walking mid, aggressive crosses and
+// (optionally) cancels of recent orders. Order ids match in both engines.
+std::vector<Op> make_flow(size_t n, uint32_t seed, int cancel_pct) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> pct(0, 99), off(1, 25), qty(1, 10), walk(-1, 1);
+  std::vector<Op> ops;
+  ops.reserve(n);
+  long mid = 10000; // ticks of 0.01
+  uint64_t next_id = 1;
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 16 == 0) mid += walk(rng);
+    int r = pct(rng);
+    Op op{};
+    if (r < cancel_pct && next_id > 64) {
+      op.cancel = true;
+      op.cancel_id = next_id - 1 - static_cast<uint64_t>(off(rng));
+    } else {
+      op.side = (pct(rng) < 50) ? Side::Buy : Side::Sell;
+      op.qty = (r < 60) ? qty(rng) : 2 * qty(rng);
+      long t = (r < 60) ? mid + (op.side == Side::Buy ? -off(rng) : off(rng))   // passive
+                        : mid + (op.side == Side::Buy ? off(rng) / 5 : -off(rng) / 5); // crossing
+      op.px = static_cast<double>(t) / 100.0;
+      ++next_id;
+    }
+    ops.push_back(op);
+  }
+  return ops;
+}
+
+template <class Engine>
+double run(Engine& eng, const std::vector<Op>& ops, size_t& fills) {
+  std::vector<Trade> sink;  // MatchingEngine refills one vector instead of returning a new one
+  auto t0 = std::chrono::steady_clock::now();
+  for (const Op& op : ops) {
+    if (op.cancel) {
+      eng.cancel(op.cancel_id);
+    } else if constexpr (std::is_same_v<Engine, MatchingEngine>) {
+      eng.new_limit_order(ClientId{1}, op.side, op.qty, op.px, sink);
+      fills += sink.size();
+    } else {
+      fills += eng.new_limit_order("bench", op.side, op.qty, op.px).size();
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(ops.size());
+}
+
+} // namespace
+
+static bool compare(const char* name, const std::vector<Op>& ops) {
+  size_t map_fills = 0, ladder_fills = 0;
+  MapBookEngine map_eng;
+  double map_ns = run(map_eng, ops, map_fills);
+  MatchingEngine ladder_eng;
+  double ladder_ns = run(ladder_eng, ops, ladder_fills);
+
+  std::printf("[%s]\n", name);
+  std::printf("  map_book    %8.1f ns/op  fills=%zu\n", map_ns, map_fills);
+  std::printf("  tick_ladder %8.1f ns/op  fills=%zu\n", ladder_ns, ladder_fills);
+  std::printf("  speedup     %8.2fx\n", map_ns / ladder_ns);
+  return map_fills == ladder_fills;
+}
+
+int main(int argc, char** argv) {
+  size_t n = (argc >= 2) ? std::stoul(argv[1]) : 2000000;
+  uint32_t seed = (argc >= 3) ? static_cast<uint32_t>(std::stoul(argv[2])) : 42;
+  std::printf("orders=%zu seed=%u\n", n, seed);
+
+  bool ok = compare("add/match", make_flow(n, seed, 0));
+  // cancels are linear in book depth in both engines, so keep this run short
+  ok &= compare("add/match/cancel", make_flow(n / 20, seed, 5));
+  return ok ? 0 : 1;
+}
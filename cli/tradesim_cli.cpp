@@ -1,6 +1,8 @@
+#include "common/client_table.hpp"
 #include "common/types.hpp"
 #include "common/util.hpp"
 #include "engine/matching_engine.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -16,12 +18,14 @@ static void print_help() {
             << "  NEW MARKET SELL <qty> CLIENT <name>\n"
             << "  CANCEL <order_id>\n"
             << "  BOOK\n"
+            << "  DEPTH <n>\n"
             << "  TRADES\n"
             << "  HELP\n"
             << "  QUIT\n";
 }
 
 struct TradeLog {
+  PriceScale scale;
   std::vector<Trade> recent;
   void add_all(const std::vector<Trade>& t) {
     recent.insert(recent.end(), t.begin(), t.end());
@@ -37,7 +41,7 @@ struct TradeLog {
       std::cout << "TRADE maker=" << tr.maker_id
                 << " taker=" << tr.taker_id
                 << " qty=" << tr.qty
-                << " px=" << std::fixed << std::setprecision(2) << tr.px
+                << " px=" << std::fixed << std::setprecision(2) << scale.to_px(tr.px)
                 << "\n";
     }
   }
@@ -46,7 +50,9 @@ struct TradeLog {
 int main() {
   std::cout << "AUM Trading Simulator — CLI (Step 1)\n";
   MatchingEngine eng;
+  ClientTable clients;
   TradeLog tlog;
+  tlog.scale = eng.scale();
   print_help();
 
   std::string line;
@@ -73,16 +79,35 @@ int main() {
         std::cout << "BID: ";
         if (top.has_bid)
           std::cout << top.bid_qty << " @ " << std::fixed
-                    << std::setprecision(2) << top.bid_px;
+                    << std::setprecision(2) << eng.scale().to_px(top.bid_px);
         else
           std::cout << "(none)";
         std::cout << "    |    ASK: ";
         if (top.has_ask)
           std::cout << top.ask_qty << " @ " << std::fixed
-                    << std::setprecision(2) << top.ask_px;
+                    << std::setprecision(2) << eng.scale().to_px(top.ask_px);
         else
           std::cout << "(none)";
         std::cout << "\n";
+      } else if (cmd == "DEPTH") {
+        size_t n = (toks.size() >= 2) ? std::stoul(toks[1]) : 5;
+        std::vector<DepthLevel> bids, asks;
+        eng.depth(n, bids, asks);
+        std::cout << std::fixed << std::setprecision(2);
+        for (size_t i = 0; i < std::max(bids.size(), asks.size()); ++i) {
+          if (i < bids.size())
+            std::cout << std::setw(8) << bids[i].qty << " @ " << std::setw(8)
+                      << eng.scale().to_px(bids[i].px) << " (" << bids[i].orders << ")";
+          else
+            std::cout << std::string(28, ' ');
+          std::cout << "    |    ";
+          if (i < asks.size())
+            std::cout << std::setw(8) << asks[i].qty << " @ " << std::setw(8)
+                      << eng.scale().to_px(asks[i].px) << " (" << asks[i].orders << ")";
+          std::cout << "\n";
+        }
+        if (bids.empty() && asks.empty())
+          std::cout << "(empty book)\n";
       } else if (cmd == "TRADES") {
         tlog.print();
       } else if (cmd == "CANCEL") {
@@ -110,7 +135,7 @@ int main() {
           }
           int qty = std::stoi(toks[3]);
           double px = std::stod(toks[5]);
-          std::string client = toks[7];
+          ClientId client = clients.intern(toks[7]);
           auto trades = eng.new_limit_order(client, side, qty, px);
           tlog.add_all(trades);
           std::cout << "OK (" << trades.size() << " trades)\n";
@@ -120,7 +145,7 @@ int main() {
             continue;
           }
           int qty = std::stoi(toks[3]);
-          std::string client = toks[5];
+          ClientId client = clients.intern(toks[5]);
           auto trades = eng.new_market_order(client, side, qty);
           tlog.add_all(trades);
           std::cout << "OK (" << trades.size() << " trades)\n";
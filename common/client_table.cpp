@@ -0,0 +1,47 @@
+#include "common/client_table.hpp"
+#include <mutex>
+
+namespace ts {
+
+ClientTable::ClientTable() {
+  for (auto& c : chunks_) c.store(nullptr, std::memory_order_relaxed);
+  chunks_[0].store(new std::string[kChunk], std::memory_order_release);  // slot 0 stays ""
+}
+
+ClientTable::~ClientTable() {
+  for (auto& c : chunks_) delete[] c.load(std::memory_order_relaxed);
+}
+
+ClientId ClientTable::find(std::string_view name) const {
+  std::shared_lock<std::shared_mutex> lk(mu_);
+  auto it = ids_.find(name);
+  return it == ids_.end() ? kNone : it->second;
+}
+
+ClientId ClientTable::intern(std::string_view name) {
+  if (name.empty()) return kNone;
+  {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+  }
+  std::unique_lock<std::shared_mutex> lk(mu_);
+  auto it = ids_.find(name);
+  if (it != ids_.end()) return it->second;
+
+  uint32_t id = count_.load(std::memory_order_relaxed);
+  size_t ci = id / kChunk;
+  if (ci >= kMaxChunks) return kNone;
+  std::string* chunk = chunks_[ci].load(std::memory_order_relaxed);
+  if (!chunk) {
+    chunk = new std::string[kChunk];
+    chunks_[ci].store(chunk, std::memory_order_release);
+  }
+  std::string& slot = chunk[id % kChunk];
+  slot.assign(name.data(), name.size());
+  ids_.emplace(std::string_view(slot), id);
+  count_.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+} // namespace ts
@@ -0,0 +1,51 @@
+#pragma once
+#include "common/types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ts {
+
+// Session-wide interning of client names to dense 32-bit ids, so orders and
+// trades carry an id and names are only looked up again at the log/wire
+// edges. Ids are handed out from 1 (0 = no client) and never reused.
+// intern() may be called from any thread. name() takes no lock: the names
+// live in fixed chunks that never move, and any thread holding an id got it
+// (directly or through a queue) after the name was stored.
+class ClientTable {
+public:
+  static constexpr ClientId kNone = 0;
+  static constexpr size_t kChunk = 4096;
+  static constexpr size_t kMaxChunks = 1024;  // ~4M names per session
+
+  ClientTable();
+  ~ClientTable();
+
+  ClientTable(const ClientTable&) = delete;
+  ClientTable& operator=(const ClientTable&) = delete;
+
+  // id for name, adding it on first sight; kNone if empty or the table is full
+  ClientId intern(std::string_view name);
+  // id for a name seen before, else kNone (never adds)
+  ClientId find(std::string_view name) const;
+
+  // "" for kNone; id must come from intern()
+  const std::string& name(ClientId id) const {
+    return chunks_[id / kChunk].load(std::memory_order_acquire)[id % kChunk];
+  }
+
+  size_t size() const { return count_.load(std::memory_order_acquire); }  // ids below are readable
+
+private:
+  mutable std::shared_mutex mu_;
+  std::unordered_map<std::string_view, ClientId> ids_;  // views into chunks_
+  std::atomic<uint32_t> count_{1};
+  std::atomic<std::string*> chunks_[kMaxChunks];
+};
+
+} // namespace ts
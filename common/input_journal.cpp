@@ -0,0 +1,414 @@
+#include "common/input_journal.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace ts {
+
+static uint32_t crc32(const void* data, size_t n, uint32_t crc = 0) {
+  static const auto table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  const auto* p = static_cast<const unsigned char*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static bool write_all(int fd, const char* p, size_t n) {
+  while (n > 0) {
+    ssize_t w = ::write(fd, p, n);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    p += w;
+    n -= static_cast<size_t>(w);
+  }
+  return true;
+}
+
+static int sync_data(int fd) {
+#ifdef __APPLE__
+  return ::fsync(fd);
+#else
+  return ::fdatasync(fd);
+#endif
+}
+
+static bool read_file(const std::string& path, std::string& out) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat st{};
+  bool ok = ::fstat(fd, &st) == 0;
+  if (ok) {
+    out.resize(static_cast<size_t>(st.st_size));
+    size_t got = 0;
+    while (ok && got < out.size()) {
+      ssize_t r = ::read(fd, &out[got], out.size() - got);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) ok = false;
+      else got += static_cast<size_t>(r);
+    }
+  }
+  ::close(fd);
+  return ok;
+}
+
+static void sync_dir(const std::string& dir) {
+  int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) { (void)::fsync(fd); ::close(fd); }
+}
+
+static std::string file_name(const std::string& dir, const char* prefix, uint64_t seq, const char* ext) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%s%020" PRIu64 "%s", prefix, seq, ext);
+  return dir + "/" + buf;
+}
+
+// (seq, path) of every dir/<prefix><seq><ext>, ascending
+static std::vector<std::pair<uint64_t, std::string>> list_files(const std::string& dir, const std::string& prefix,
+                                                                const std::string& ext) {
+  std::vector<std::pair<uint64_t, std::string>> out;
+  DIR* d = ::opendir(dir.c_str());
+  if (!d) return out;
+  while (dirent* e = ::readdir(d)) {
+    std::string name = e->d_name;
+    if (name.size() <= prefix.size() + ext.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - ext.size(), ext.size(), ext) != 0)
+      continue;
+    std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - ext.size());
+    auto is_digit = [](char ch) { return std::isdigit(static_cast<unsigned char>(ch)) != 0; };
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), is_digit)) continue;
+    out.emplace_back(std::stoull(digits), dir + "/" + name);
+  }
+  ::closedir(d);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+InputJournal::InputJournal(const InputJournalConfig& cfg, const ClientTable& names,
+                           std::vector<JournalSymbol> symbols)
+    : cfg_(cfg), names_(names), symbols_(std::move(symbols)) {}
+
+InputJournal::~InputJournal() {
+  stop();
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool InputJournal::open(uint64_t next_seq) {
+  ::mkdir(cfg_.dir.c_str(), 0755);
+  seq_.store(next_seq - 1, std::memory_order_release);
+  snap_seq_ = next_seq - 1;
+  return open_segment(next_seq);
+}
+
+bool InputJournal::open_segment(uint64_t first_seq) {
+  if (symbols_.size() > kJournalMaxSymbols) return false;
+  std::string path = file_name(cfg_.dir, "input_", first_seq, ".log");
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  InputSegmentHeader h{};
+  std::memcpy(h.magic, kInputMagic, sizeof(h.magic));
+  h.version = kInputVersion;
+  h.header_size = sizeof(h);
+  h.symbol_count = static_cast<uint32_t>(symbols_.size());
+  h.first_seq = first_seq;
+  for (size_t i = 0; i < symbols_.size(); ++i) h.symbols[i] = symbols_[i];
+  if (!write_all(fd, reinterpret_cast<const char*>(&h), sizeof(h)) || (cfg_.fsync && ::fsync(fd) != 0)) {
+    ::close(fd);
+    return false;
+  }
+  if (cfg_.fsync) sync_dir(cfg_.dir);
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = fd;
+  return true;
+}
+
+void InputJournal::start() {
+  if (writer_.joinable()) return;
+  writer_ = std::thread([this] { run(); });
+}
+
+void InputJournal::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  if (writer_.joinable()) writer_.join();
+}
+
+void InputJournal::append(const InputCommand& cmd, Done then) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    queue_.push_back(Pending{cmd, std::move(then), true});
+  }
+  cv_.notify_one();
+}
+
+void InputJournal::append_batch(const std::vector<InputCommand>& cmds, Done then) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (size_t i = 0; i + 1 < cmds.size(); ++i) queue_.push_back(Pending{cmds[i], nullptr, true});
+    queue_.push_back(Pending{cmds.empty() ? InputCommand{} : cmds.back(), std::move(then), !cmds.empty()});
+  }
+  cv_.notify_one();
+}
+
+void InputJournal::after(Done then) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    queue_.push_back(Pending{InputCommand{}, std::move(then), false});
+  }
+  cv_.notify_one();
+}
+
+void InputJournal::save_snapshot(uint64_t seq, std::string blob) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    snapshots_.emplace_back(seq, std::move(blob));
+  }
+  cv_.notify_one();
+}
+
+InputJournalStats InputJournal::stats() const {
+  InputJournalStats s;
+  s.records = records_.load(std::memory_order_relaxed);
+  s.commits = commits_.load(std::memory_order_relaxed);
+  s.snapshots = snapshots_written_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void InputJournal::run() {
+  std::vector<Pending> batch;
+  std::vector<std::pair<uint64_t, std::string>> snaps;
+  std::string buf;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cv_.wait(lk, [this] { return !queue_.empty() || !snapshots_.empty() || stopping_; });
+      if (queue_.empty() && snapshots_.empty() && stopping_) break;
+      batch.swap(queue_);
+      snaps.swap(snapshots_);
+    }
+
+    if (!batch.empty()) {
+      // one write and one sync for everything that queued up meanwhile
+      uint64_t seq = seq_.load(std::memory_order_relaxed);
+      uint64_t first = seq;
+      buf.clear();
+      for (auto& item : batch) {
+        if (!item.record) continue;
+        const InputCommand& c = item.cmd;
+        const std::string& name = names_.name(c.client);
+        InputRecord r{};
+        r.seq = ++seq;
+        r.order_id = c.order_id;
+        r.px = c.px;
+        r.qty = c.qty;
+        r.symbol = c.symbol;
+        r.kind = static_cast<uint8_t>(c.kind);
+        r.side = static_cast<uint8_t>(c.side);
+        r.name_len = static_cast<uint32_t>(name.size());
+        r.crc = crc32(name.data(), name.size(), crc32(&r, sizeof(r)));
+        buf.append(reinterpret_cast<const char*>(&r), sizeof(r));
+        buf.append(name);
+      }
+      if (seq != first && !failed()) {
+        bool ok = fd_ >= 0 && write_all(fd_, buf.data(), buf.size()) &&
+                  (!cfg_.fsync || sync_data(fd_) == 0);
+        if (ok) {
+          seq_.store(seq, std::memory_order_release);
+          records_.fetch_add(seq - first, std::memory_order_relaxed);
+          commits_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          // records past a torn one would never be replayed: stop here
+          std::cerr << "error: input journal write failed after seq " << first
+                    << "; order entry halted\n";
+          failed_.store(true, std::memory_order_release);
+        }
+      }
+      if (failed()) seq = first;
+
+      bool durable = !failed();
+      for (auto& item : batch) if (item.then) item.then(durable);
+      batch.clear();
+
+      if (cfg_.snapshot_every && seq - snap_seq_ >= cfg_.snapshot_every) {
+        // new segment from here, so the snapshot at seq retires all older ones
+        snap_seq_ = seq;
+        if (!open_segment(seq + 1) && !warned_) {
+          std::cerr << "warning: cannot rotate input journal in " << cfg_.dir << "\n";
+          warned_ = true;
+        }
+        if (on_checkpoint_) on_checkpoint_(seq);
+      }
+    }
+
+    for (auto& s : snaps) write_snapshot(s.first, s.second);
+    snaps.clear();
+  }
+}
+
+void InputJournal::write_snapshot(uint64_t seq, const std::string& blob) {
+  if (!write_snapshot_file(cfg_.dir, seq, blob)) {
+    std::cerr << "warning: cannot write snapshot " << seq << " in " << cfg_.dir << "\n";
+    return;
+  }
+  snapshots_written_.fetch_add(1, std::memory_order_relaxed);
+  prune_journal(cfg_.dir, seq);
+}
+
+void prune_journal(const std::string& dir, uint64_t seq) {
+  // segments end where the next one begins; drop those wholly covered by seq
+  auto segs = list_files(dir, "input_", ".log");
+  for (size_t i = 0; i + 1 < segs.size(); ++i) {
+    if (segs[i + 1].first <= seq + 1) ::unlink(segs[i].second.c_str());
+  }
+  for (auto& s : list_files(dir, "snapshot_", ".bin")) {
+    if (s.first < seq) ::unlink(s.second.c_str());
+  }
+}
+
+bool write_snapshot_file(const std::string& dir, uint64_t seq, const std::string& blob) {
+  ::mkdir(dir.c_str(), 0755);
+  std::string path = file_name(dir, "snapshot_", seq, ".bin");
+  std::string tmp = path + ".tmp";
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  SnapshotFileHeader h{};
+  std::memcpy(h.magic, kSnapshotMagic, sizeof(h.magic));
+  h.version = kInputVersion;
+  h.crc = crc32(blob.data(), blob.size());
+  h.seq = seq;
+  h.size = blob.size();
+  bool ok = write_all(fd, reinterpret_cast<const char*>(&h), sizeof(h)) &&
+            write_all(fd, blob.data(), blob.size()) && ::fsync(fd) == 0;
+  ::close(fd);
+  if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    return false;
+  }
+  sync_dir(dir);
+  return true;
+}
+
+bool load_latest_snapshot(const std::string& dir, uint64_t& seq, std::string& blob) {
+  auto snaps = list_files(dir, "snapshot_", ".bin");
+  for (auto it = snaps.rbegin(); it != snaps.rend(); ++it) {
+    std::string data;
+    if (!read_file(it->second, data) || data.size() < sizeof(SnapshotFileHeader)) continue;
+    SnapshotFileHeader h;
+    std::memcpy(&h, data.data(), sizeof(h));
+    if (std::memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0 || h.version != kInputVersion ||
+        h.size != data.size() - sizeof(h))
+      continue;
+    blob.assign(data, sizeof(h), std::string::npos);
+    if (crc32(blob.data(), blob.size()) != h.crc) continue;
+    seq = h.seq;
+    return true;
+  }
+  return false;
+}
+
+bool read_segment_header(std::string_view data, InputSegmentHeader& h) {
+  if (data.size() < sizeof(h)) return false;
+  std::memcpy(&h, data.data(), sizeof(h));
+  return std::memcmp(h.magic, kInputMagic, sizeof(h.magic)) == 0 && h.version == kInputVersion &&
+         h.header_size == sizeof(h) && h.symbol_count <= kJournalMaxSymbols;
+}
+
+bool replay_segment(std::string_view data, uint64_t& last, const ReplayFn& f) {
+  InputSegmentHeader h;
+  if (!read_segment_header(data, h)) return true;
+  size_t off = sizeof(h);
+  while (off + sizeof(InputRecord) <= data.size()) {
+    InputRecord r;
+    std::memcpy(&r, data.data() + off, sizeof(r));
+    if (off + sizeof(r) + r.name_len > data.size()) break;  // torn tail
+    std::string_view name(data.data() + off + sizeof(r), r.name_len);
+    uint32_t crc = r.crc;
+    r.crc = 0;
+    if (crc32(name.data(), name.size(), crc32(&r, sizeof(r))) != crc) break;
+    off += sizeof(r) + r.name_len;
+    if (r.seq <= last) continue;      // covered by the snapshot
+    if (r.seq != last + 1) return false;  // gap: nothing after it can be trusted
+    if (r.symbol >= h.symbol_count) return false;
+
+    InputCommand c;
+    c.kind = static_cast<InputKind>(r.kind);
+    c.side = static_cast<Side>(r.side);
+    c.symbol = r.symbol;
+    c.qty = r.qty;
+    c.px = r.px;
+    c.order_id = r.order_id;
+    const JournalSymbol& js = h.symbols[r.symbol];
+    f(c, std::string_view(js.name, strnlen(js.name, sizeof(js.name))), name);
+    last = r.seq;
+  }
+  return true;
+}
+
+uint64_t replay_input(const std::string& dir, uint64_t after, const ReplayFn& f) {
+  uint64_t last = after;
+  std::string data;
+  for (auto& seg : list_files(dir, "input_", ".log")) {
+    if (!read_file(seg.second, data)) continue;
+    if (!replay_segment(data, last, f)) return last;
+  }
+  return last;
+}
+
+bool parse_command(const TokenViews& toks, ClientTable& names, InputCommand& in, std::string& err) {
+  in = InputCommand{};
+  if (toks.size() >= 8 && toks[0]=="NEW" && toks[1]=="LIMIT" && toks[6]=="CLIENT") {
+    in.kind = InputKind::NewLimit;
+    in.side = (toks[2]=="BUY") ? Side::Buy : Side::Sell;
+    if (!parse_int(toks[3], in.qty) || !parse_double(toks[5], in.px)) { err = "ERROR parsing command"; return false; }
+    if (in.qty <= 0) { err = "ERROR bad quantity"; return false; }
+    if (!(in.px > 0)) { err = "ERROR bad price"; return false; }  // sub-tick prices: the engine knows the tick
+    in.client = names.intern(toks[7]);
+  } else if (toks.size() >= 6 && toks[0]=="NEW" && toks[1]=="MARKET" && toks[4]=="CLIENT") {
+    in.kind = InputKind::NewMarket;
+    in.side = (toks[2]=="BUY") ? Side::Buy : Side::Sell;
+    if (!parse_int(toks[3], in.qty)) { err = "ERROR parsing command"; return false; }
+    if (in.qty <= 0) { err = "ERROR bad quantity"; return false; }
+    in.client = names.intern(toks[5]);
+  } else if (toks.size() >= 4 && toks[0] == "CANCEL" && toks[1] == "ALL" && toks[2] == "CLIENT") {
+    in.kind = InputKind::CancelAll;
+    in.client = names.intern(toks[3]);
+  } else if (toks.size() >= 5 && toks[0] == "REPLACE" && toks[3] == "@") {
+    // REPLACE <id> <qty> @ <px>: qty is the new open quantity
+    in.kind = InputKind::Replace;
+    if (!parse_int(toks[1], in.order_id) || !parse_int(toks[2], in.qty) || !parse_double(toks[4], in.px) ||
+        in.qty <= 0) {
+      err = "ERROR usage: REPLACE <id> <qty> @ <px>";
+      return false;
+    }
+    return true;
+  } else if (toks[0] == "CANCEL" && toks.size() >= 2) {
+    in.kind = InputKind::Cancel;
+    if (!parse_int(toks[1], in.order_id)) { err = "ERROR parsing command"; return false; }
+    return true;
+  } else {
+    err = "ERROR unknown command";
+    return false;
+  }
+  if (in.client == ClientTable::kNone) { err = "ERROR bad client"; return false; }
+  return true;
+}
+
+} // namespace ts
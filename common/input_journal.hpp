@@ -0,0 +1,198 @@
+#pragma once
+#include "common/client_table.hpp"
+#include "common/trade_journal.hpp"
+#include "common/types.hpp"
+#include "common/util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+// Write-ahead journal of every state-changing command, so the books can be
+// rebuilt after a crash: load the newest snapshot, then replay the commands
+// logged after it. Files live in one directory:
+//
+//   input_<first seq>.log     [InputSegmentHeader][InputRecord + client name] * N
+//   snapshot_<seq>.bin        [SnapshotFileHeader][blob]   state after command <seq>
+//
+// Segments are rotated at every snapshot point, so once a snapshot is on
+// disk every older segment and snapshot can go and restart cost is bounded
+// by snapshot size plus one segment.
+
+enum class InputKind : uint8_t { NewLimit = 1, NewMarket = 2, Cancel = 3, Replace = 4, CancelAll = 5 };
+
+// One accepted command, as the matching engine will execute it.
+struct InputCommand {
+  InputKind kind{InputKind::NewLimit};
+  Side side{Side::Buy};
+  uint16_t symbol{0};     // registry index
+  int32_t qty{0};
+  ClientId client{0};     // NEW orders, CANCEL ALL
+  double px{0};           // NEW LIMIT / REPLACE price exactly as received
+  uint64_t order_id{0};   // CANCEL / REPLACE target
+};
+
+constexpr char kInputMagic[8] = {'T', 'S', 'I', 'N', 'P', 'U', 'T', 'S'};
+constexpr char kSnapshotMagic[8] = {'T', 'S', 'S', 'N', 'A', 'P', 'S', 'H'};
+constexpr uint32_t kInputVersion = 1;
+
+struct InputSegmentHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t symbol_count;
+  uint32_t reserved;
+  uint64_t first_seq;
+  uint8_t reserved0[32];
+  JournalSymbol symbols[kJournalMaxSymbols];  // records name symbols by index into this
+  uint8_t reserved1[1024 - 64 - kJournalMaxSymbols * sizeof(JournalSymbol)];
+};
+static_assert(sizeof(InputSegmentHeader) == 1024, "input segment header layout");
+
+struct InputRecord {
+  uint64_t seq;
+  uint64_t order_id;
+  double px;
+  int32_t qty;
+  uint16_t symbol;
+  uint8_t kind;
+  uint8_t side;
+  uint32_t name_len;  // client name bytes that follow the record
+  uint32_t crc;       // CRC-32 of the record (crc = 0) and the name
+};
+static_assert(sizeof(InputRecord) == 40, "input record layout");
+
+struct SnapshotFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t crc;       // CRC-32 of the blob
+  uint64_t seq;       // last command reflected in the blob
+  uint64_t size;      // blob bytes
+};
+
+struct InputJournalConfig {
+  std::string dir{"state"};
+  bool fsync{true};                // fdatasync each group commit
+  uint64_t snapshot_every{100000}; // commands between snapshots
+};
+
+struct InputJournalStats {
+  uint64_t records{0};
+  uint64_t commits{0};  // write (+ sync) calls; records / commits = group size
+  uint64_t snapshots{0};
+};
+
+// Group-committing writer. append() queues a command with a continuation;
+// the writer thread takes everything queued, writes it with one write() and
+// one fdatasync(), then runs the continuations in sequence order. Callers
+// put the actual execution (and the reply) in the continuation, so nothing
+// is acknowledged before it is durable and the journal order is the order
+// the books see.
+//
+// A failed write or sync may leave a torn record, and replay stops there.
+// The journal then fails for good: nothing more is written, and every
+// continuation from that batch on is called with durable = false, so the
+// caller answers ERROR instead of executing.
+class InputJournal {
+public:
+  using Done = std::function<void(bool durable)>;
+  using Checkpoint = std::function<void(uint64_t seq)>;
+
+  InputJournal(const InputJournalConfig& cfg, const ClientTable& names,
+               std::vector<JournalSymbol> symbols);
+  ~InputJournal();
+
+  InputJournal(const InputJournal&) = delete;
+  InputJournal& operator=(const InputJournal&) = delete;
+
+  // before start(): open a fresh segment whose first record is next_seq
+  bool open(uint64_t next_seq);
+  // before start(): called on the writer thread at each snapshot point, after
+  // the continuations up to seq ran; answer with save_snapshot(seq, ...)
+  void set_checkpoint_handler(Checkpoint h) { on_checkpoint_ = std::move(h); }
+
+  void start();
+  void stop();  // writes and dispatches everything queued, then joins
+
+  void append(const InputCommand& cmd, Done then);   // any thread
+  // any thread: cmds as consecutive records in one commit, then one continuation
+  void append_batch(const std::vector<InputCommand>& cmds, Done then);
+  // any thread: run then after everything appended so far, writing nothing
+  // (keeps a query behind the same client's journaled commands); durable
+  // is false once the journal failed
+  void after(Done then);
+  void save_snapshot(uint64_t seq, std::string blob);  // any thread; older files pruned after
+
+  uint64_t last_seq() const { return seq_.load(std::memory_order_acquire); }  // last durable record
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+  InputJournalStats stats() const;
+
+private:
+  InputJournalConfig cfg_;
+  const ClientTable& names_;
+  std::vector<JournalSymbol> symbols_;
+  Checkpoint on_checkpoint_;
+  int fd_{-1};
+  std::atomic<uint64_t> seq_{0};  // last record written
+  uint64_t snap_seq_{0};          // last snapshot point
+  bool warned_{false};
+  std::atomic<bool> failed_{false};  // a write failed: no more records, no more acks
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  struct Pending {
+    InputCommand cmd;
+    Done then;
+    bool record;
+  };
+  std::vector<Pending> queue_;
+  std::vector<std::pair<uint64_t, std::string>> snapshots_;
+  bool stopping_{false};
+  std::thread writer_;
+
+  std::atomic<uint64_t> records_{0}, commits_{0}, snapshots_written_{0};
+
+  void run();
+  bool open_segment(uint64_t first_seq);
+  void write_snapshot(uint64_t seq, const std::string& blob);
+};
+
+// --- recovery ---
+
+// Newest intact snapshot in dir; false if there is none.
+bool load_latest_snapshot(const std::string& dir, uint64_t& seq, std::string& blob);
+// Durably replace the snapshot for seq (temp file, fsync, rename).
+bool write_snapshot_file(const std::string& dir, uint64_t seq, const std::string& blob);
+
+// Remove segments and snapshots made obsolete by the snapshot at seq.
+void prune_journal(const std::string& dir, uint64_t seq);
+
+// Calls f(cmd, symbol name, client name) for each logged command with
+// seq > after, in order, and returns the last seq seen (after if none).
+// Reading stops at the first torn or corrupt record or sequence gap: that
+// is where the previous run stopped writing. cmd.client is left 0.
+using ReplayFn = std::function<void(const InputCommand&, std::string_view symbol, std::string_view client)>;
+uint64_t replay_input(const std::string& dir, uint64_t after, const ReplayFn& f);
+
+// One segment file's bytes (read or mmapped): the same, for records with
+// seq > last, advancing last. False at a sequence gap, where the caller must
+// stop too; a bad header or a torn tail only ends this segment.
+bool replay_segment(std::string_view data, uint64_t& last, const ReplayFn& f);
+// false unless data starts with a valid v1 segment header
+bool read_segment_header(std::string_view data, InputSegmentHeader& h);
+
+// NEW LIMIT / NEW MARKET / CANCEL / REPLACE / CANCEL ALL in the wire grammar
+// (SYMBOL already taken out), client names interned in names; else false
+// with the ERROR reply in err. cmd.symbol is left 0.
+bool parse_command(const TokenViews& toks, ClientTable& names, InputCommand& cmd, std::string& err);
+
+} // namespace ts
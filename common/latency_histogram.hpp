@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ts {
+
+// Log-linear histogram in the style of HdrHistogram: values below 128 are
+// counted exactly, above that each power of two is split into 64 buckets,
+// so any recorded value is off by less than 1/64 (~1.6%). Fixed size, no
+// allocation, O(1) record; meant for nanosecond latencies.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 7;
+  static constexpr uint64_t kSub = uint64_t{1} << kSubBits;  // exact range
+  static constexpr uint64_t kHalf = kSub / 2;
+  static constexpr size_t kBuckets = kSub + (64 - kSubBits) * kHalf;
+
+  void record(uint64_t v) {
+    ++counts_[bucket_of(v)];
+    ++count_;
+    sum_ += v;
+    max_ = std::max(max_, v);
+    min_ = std::min(min_, v);
+  }
+
+  void merge(const LatencyHistogram& o) {
+    for (size_t i = 0; i < kBuckets; ++i) counts_[i] += o.counts_[i];
+    count_ += o.count_;
+    sum_ += o.sum_;
+    max_ = std::max(max_, o.max_);
+    min_ = std::min(min_, o.min_);
+  }
+
+  void reset() { *this = LatencyHistogram(); }
+
+  // n samples known only by bucket (e.g. copied from another thread's
+  // counters): mean and max use the bucket's upper bound
+  void add_bucket(size_t i, uint64_t n) {
+    if (n == 0) return;
+    counts_[i] += n;
+    count_ += n;
+    sum_ += bucket_top(i) * n;
+    max_ = std::max(max_, bucket_top(i));
+    min_ = std::min(min_, bucket_top(i));
+  }
+
+  static size_t bucket_of(uint64_t v) {
+    if (v < kSub) return static_cast<size_t>(v);
+    int shift = (63 - __builtin_clzll(v)) - (kSubBits - 1);  // leaves v >> shift in [kHalf, kSub)
+    return static_cast<size_t>(kSub + (shift - 1) * kHalf + ((v >> shift) - kHalf));
+  }
+
+  // largest value counted in bucket i
+  static uint64_t bucket_top(size_t i) {
+    if (i < kSub) return i;
+    uint64_t shift = (i - kSub) / kHalf + 1;
+    uint64_t top = (i - kSub) % kHalf + kHalf;
+    return ((top + 1) << shift) - 1;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+  // smallest bucket bound with at least q (0..1) of the samples at or below
+  // it, capped at the exact max; 0 when empty
+  uint64_t percentile(double q) const {
+    if (count_ == 0) return 0;
+    uint64_t want = static_cast<uint64_t>(q * static_cast<double>(count_) + 0.5);
+    want = std::clamp<uint64_t>(want, 1, count_);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= want) return std::min(bucket_top(i), max_);
+    }
+    return max_;
+  }
+
+private:
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+  uint64_t min_{UINT64_MAX};
+};
+
+} // namespace ts
@@ -1,52 +1,168 @@
 #include "common/logger.hpp"
 #include <sys/stat.h>
-#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace ts {
 
-// little helper to check if file exists and has non-zero size
-static bool file_has_data(const std::string& path) {
-  struct stat st{};
-  if (stat(path.c_str(), &st) != 0) return false;
-  return st.st_size > 0;
+static bool write_all(int fd, const char* p, size_t n) {
+  while (n > 0) {
+    ssize_t w = ::write(fd, p, n);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    p += w;
+    n -= static_cast<size_t>(w);
+  }
+  return true;
+}
+
+AsyncLogger::AsyncLogger(const LogConfig& cfg) : cfg_(cfg), ring_(cfg.ring_capacity) {}
+
+AsyncLogger::~AsyncLogger() {
+  stop();
+  for (int& fd : fds_) {
+    if (fd >= 0) { ::close(fd); fd = -1; }
+  }
 }
 
-CsvLogger::~CsvLogger() {
-  if (fp_) { std::fflush(fp_); std::fclose(fp_); fp_ = nullptr; }
+bool AsyncLogger::open_journal(const std::string& path, uint64_t session_id,
+                               const std::vector<JournalSymbol>& symbols) {
+  int& fd = fds_[static_cast<size_t>(LogKind::Trade)];
+  if (fd >= 0) ::close(fd);
+  fd = open_trade_journal(path, session_id, symbols);
+  return fd >= 0;
 }
 
-bool CsvLogger::open(const std::string& path, const std::vector<std::string>& header) {
-  std::lock_guard<std::mutex> lk(mu_);
-  if (fp_) { std::fflush(fp_); std::fclose(fp_); fp_ = nullptr; }
-  fp_ = std::fopen(path.c_str(), "a");
-  if (!fp_) return false;
+bool AsyncLogger::open_book_csv(const std::string& path, const std::vector<std::string>& header) {
+  int& fd = fds_[static_cast<size_t>(LogKind::Book)];
+  if (fd >= 0) ::close(fd);
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
 
-  if (!file_has_data(path) && !header.empty()) {
-    // write header
+  struct stat st{};
+  if (::fstat(fd, &st) == 0 && st.st_size == 0 && !header.empty()) {
+    std::string line;
     for (size_t i = 0; i < header.size(); ++i) {
-      if (i) std::fputc(',', fp_);
-      std::fputs(header[i].c_str(), fp_);
+      if (i) line += ',';
+      line += header[i];
     }
-    std::fputc('\n', fp_);
-    std::fflush(fp_);
+    line += '\n';
+    write_all(fd, line.data(), line.size());
   }
   return true;
 }
 
-void CsvLogger::write_row(const std::vector<std::string>& row) {
-  std::lock_guard<std::mutex> lk(mu_);
-  if (!fp_) return;
-  for (size_t i = 0; i < row.size(); ++i) {
-    if (i) std::fputc(',', fp_);
-    std::fputs(row[i].c_str(), fp_);
+void AsyncLogger::start() {
+  if (running_.exchange(true)) return;
+  writer_ = std::thread([this] { run(); });
+}
+
+void AsyncLogger::stop() {
+  if (!running_.exchange(false)) return;
+  if (writer_.joinable()) writer_.join();
+}
+
+void AsyncLogger::log(const LogRecord& rec) {
+  if (ring_.try_push(rec)) return;
+  if (!cfg_.block_when_full || !running_.load(std::memory_order_relaxed)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
   }
-  std::fputc('\n', fp_);
+  // backpressure: wait for the writer to free a cell
+  blocked_.fetch_add(1, std::memory_order_relaxed);
+  while (!ring_.try_push(rec)) std::this_thread::yield();
 }
 
-void CsvLogger::flush() {
-  std::lock_guard<std::mutex> lk(mu_);
-  if (fp_) std::fflush(fp_);
+LogStats AsyncLogger::stats() const {
+  LogStats s;
+  s.written = written_.load(std::memory_order_relaxed);
+  s.dropped = dropped_.load(std::memory_order_relaxed);
+  s.blocked = blocked_.load(std::memory_order_relaxed);
+  return s;
 }
 
-} // namespace ts
+void AsyncLogger::run() {
+  using clock = std::chrono::steady_clock;
+  constexpr size_t kBatch = 1024;
+  const auto interval = std::chrono::milliseconds(cfg_.flush_interval_ms);
+  auto last_flush = clock::now();
+  LogRecord rec;
+
+  while (true) {
+    // read the flag before draining so nothing logged before stop() is missed
+    bool running = running_.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (n < kBatch && ring_.try_pop(rec)) {
+      format(rec);
+      ++n;
+    }
+    if (n) written_.fetch_add(n, std::memory_order_relaxed);
+
+    size_t buffered = pending_[0].size() + pending_[1].size();
+    auto now = clock::now();
+    if (buffered >= cfg_.flush_bytes ||
+        (buffered && cfg_.flush_interval_ms && now - last_flush >= interval)) {
+      write_out(false);
+      last_flush = now;
+    }
+    if (n == kBatch) continue;
+    if (!running) break;
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  write_out(cfg_.fsync_on_close);
+}
+
+JournalTrade encode_trade(const LogRecord& r, const ClientTable* names) {
+  const auto& t = r.trade;
+  JournalTrade j{};
+  j.ts_ns = r.ts_ns;
+  j.maker_id = t.maker_id;
+  j.taker_id = t.taker_id;
+  j.px = t.px;
+  j.qty = t.qty;
+  j.symbol = t.symbol_id;
+  j.maker_side = static_cast<uint8_t>(t.maker_side);
+  j.taker_side = static_cast<uint8_t>(t.taker_side);
+  if (names) {
+    copy_field(j.maker_client, names->name(t.maker_client));
+    copy_field(j.taker_client, names->name(t.taker_client));
+  }
+  return j;
+}
+
+void AsyncLogger::format(const LogRecord& r) {
+  if (r.kind == LogKind::Trade) {
+    JournalTrade j = encode_trade(r, names_);
+    pending_[static_cast<size_t>(LogKind::Trade)].append(reinterpret_cast<const char*>(&j), sizeof(j));
+    return;
+  }
 
+  const auto& b = r.book;
+  char line[256];
+  char bid_px[32] = "", bid_qty[16] = "", ask_px[32] = "", ask_qty[16] = "";
+  if (b.has_bid) {
+    std::snprintf(bid_px, sizeof(bid_px), "%f", b.bid_px);
+    std::snprintf(bid_qty, sizeof(bid_qty), "%d", b.bid_qty);
+  }
+  if (b.has_ask) {
+    std::snprintf(ask_px, sizeof(ask_px), "%f", b.ask_px);
+    std::snprintf(ask_qty, sizeof(ask_qty), "%d", b.ask_qty);
+  }
+  int len = std::snprintf(line, sizeof(line), "%llu,%d,%s,%s,%d,%s,%s,%s\n",
+                          static_cast<unsigned long long>(r.ts_ns), b.has_bid ? 1 : 0, bid_px,
+                          bid_qty, b.has_ask ? 1 : 0, ask_px, ask_qty, r.symbol);
+  if (len > 0) pending_[static_cast<size_t>(LogKind::Book)].append(line, static_cast<size_t>(len));
+}
+
+void AsyncLogger::write_out(bool sync) {
+  for (size_t k = 0; k < kKinds; ++k) {
+    if (fds_[k] >= 0 && !pending_[k].empty()) write_all(fds_[k], pending_[k].data(), pending_[k].size());
+    pending_[k].clear();
+    if (sync && fds_[k] >= 0) ::fsync(fds_[k]);
+  }
+}
+
+} // namespace ts
@@ -1,31 +1,115 @@
 #pragma once
-#include <cstdio>
-#include <mutex>
+#include "common/client_table.hpp"
+#include "common/mpsc_ring.hpp"
+#include "common/trade_journal.hpp"
+#include "common/types.hpp"
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 namespace ts {
 
-// Simple CSV logger (thread-safe). Opens a file in append mode.
-// If the file is empty, writes a header as the first row.
-class CsvLogger {
+enum class LogKind : uint8_t { Trade = 0, Book = 1 };
+
+// Fixed-size event record. Producers fill one in and hand it over; the
+// writer thread does all number formatting and file I/O.
+struct LogRecord {
+  struct TradeRow {
+    uint64_t maker_id, taker_id;
+    Price px;  // ticks of symbol_id
+    int32_t qty;
+    uint16_t symbol_id;  // index into the journal's symbol table
+    Side maker_side, taker_side;
+    ClientId maker_client, taker_client;  // names resolved by the writer
+  };
+  struct BookRow {
+    double bid_px, ask_px;
+    int32_t bid_qty, ask_qty;
+    bool has_bid, has_ask;
+  };
+
+  LogKind kind{LogKind::Trade};
+  uint64_t ts_ns{0};
+  char symbol[16]{};  // book rows only
+  union {
+    TradeRow trade;
+    BookRow book;
+  };
+
+  LogRecord() : trade{} {}
+};
+
+// copy into a fixed field, truncating; always NUL-terminated
+template <size_t N>
+inline void copy_field(char (&dst)[N], std::string_view s) {
+  size_t n = s.size() < N - 1 ? s.size() : N - 1;
+  s.copy(dst, n);
+  dst[n] = '\0';
+}
+
+// The journal record a trade row becomes; client names through names (may be null)
+JournalTrade encode_trade(const LogRecord& rec, const ClientTable* names);
+
+struct LogConfig {
+  size_t ring_capacity{1 << 16};    // records, rounded up to a power of two
+  bool block_when_full{false};      // false: drop and count; true: producer waits
+  uint32_t flush_interval_ms{100};  // write out at least this often (0: only size/close)
+  size_t flush_bytes{64 << 10};     // ...or once this much text is buffered
+  bool fsync_on_close{false};
+};
+
+struct LogStats {
+  uint64_t written{0};  // records encoded by the writer
+  uint64_t dropped{0};  // records lost to a full ring
+  uint64_t blocked{0};  // records whose producer had to wait for space
+};
+
+// Asynchronous event logger. log() is lock-free and never touches the disk;
+// a writer thread drains the ring in batches and appends trades to a binary
+// journal (see trade_journal.hpp) and book snapshots to a CSV.
+class AsyncLogger {
 public:
-  CsvLogger() = default;
-  ~CsvLogger();
+  explicit AsyncLogger(const LogConfig& cfg = {});
+  ~AsyncLogger();
+
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
 
-  // Open (or reopen) a CSV file at 'path'. If header.size()>0 and file is empty, write header.
-  bool open(const std::string& path, const std::vector<std::string>& header);
+  // before start(): append trades to a binary journal at path
+  bool open_journal(const std::string& path, uint64_t session_id,
+                    const std::vector<JournalSymbol>& symbols);
+  // before start(): table that resolves client ids in trade rows
+  void set_client_names(const ClientTable* names) { names_ = names; }
+  // before start(): append book rows to a CSV, writing header if the file is empty
+  bool open_book_csv(const std::string& path, const std::vector<std::string>& header);
 
-  // Append a row; items are written as plain text separated by commas.
-  void write_row(const std::vector<std::string>& row);
+  void start();
+  void stop();  // drains the ring, flushes, fsyncs if configured
 
-  // Flush buffered data to disk.
-  void flush();
+  void log(const LogRecord& rec);  // any thread
+  LogStats stats() const;
 
 private:
-  std::FILE* fp_{nullptr};
-  std::mutex mu_;
+  static constexpr size_t kKinds = 2;
+
+  LogConfig cfg_;
+  const ClientTable* names_{nullptr};
+  MpscRing<LogRecord> ring_;
+  int fds_[kKinds]{-1, -1};
+  std::string pending_[kKinds];  // encoded, not yet written
+  std::thread writer_;
+  std::atomic<bool> running_{false};
+
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> blocked_{0};
+
+  void run();
+  void format(const LogRecord& rec);
+  void write_out(bool sync);
 };
 
 } // namespace ts
-
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace ts {
+
+// Bounded lock-free queue: any number of producers, one consumer.
+// Each cell carries a sequence number (Vyukov's bounded queue), so a
+// producer claims a cell with one CAS and the consumer never takes a lock.
+template <class T>
+class MpscRing {
+public:
+  // capacity is rounded up to a power of two
+  explicit MpscRing(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    cells_.reset(new Cell[cap]);
+    for (size_t i = 0; i < cap; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  MpscRing(const MpscRing&) = delete;
+  MpscRing& operator=(const MpscRing&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // any thread; false when full
+  template <class U>
+  bool try_push(U&& v) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& c = cells_[pos & mask_];
+      size_t seq = c.seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (dif == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.value = std::forward<U>(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false;  // the consumer has not freed this cell yet
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // consumer thread only; false when empty
+  bool try_pop(T& out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    Cell& c = cells_[tail & mask_];
+    size_t seq = c.seq.load(std::memory_order_acquire);
+    if (seq != tail + 1) return false;
+    out = std::move(c.value);
+    c.seq.store(tail + mask_ + 1, std::memory_order_release);
+    tail_.store(tail + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // consumer thread only: nothing published to pop
+  bool empty() const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    return cells_[tail & mask_].seq.load(std::memory_order_acquire) != tail + 1;
+  }
+
+  // any thread: claimed but not yet popped cells (a snapshot, for metrics)
+  size_t size_approx() const {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> seq{0};
+    T value{};
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_{0};
+  alignas(64) std::atomic<size_t> head_{0};  // producers
+  alignas(64) std::atomic<size_t> tail_{0};  // written by the consumer only
+};
+
+} // namespace ts
@@ -0,0 +1,82 @@
+#include "common/trade_journal.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ts {
+
+static bool valid_header(const JournalHeader& h) {
+  return std::memcmp(h.magic, kJournalMagic, sizeof(h.magic)) == 0 && h.version == kJournalVersion &&
+         h.header_size == sizeof(JournalHeader) && h.record_size == sizeof(JournalTrade) &&
+         h.symbol_count <= kJournalMaxSymbols;
+}
+
+int open_trade_journal(const std::string& path, uint64_t session_id,
+                       const std::vector<JournalSymbol>& symbols) {
+  if (symbols.size() > kJournalMaxSymbols) return -1;
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) return -1;
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) { ::close(fd); return -1; }
+  if (st.st_size > 0) {
+    // reopening an existing session: keep its header, drop a torn tail record
+    JournalHeader h{};
+    if (::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) || !valid_header(h)) {
+      ::close(fd);
+      return -1;
+    }
+    off_t body = st.st_size - static_cast<off_t>(sizeof(h));
+    off_t whole = body - body % static_cast<off_t>(sizeof(JournalTrade));
+    if (whole != body && ::ftruncate(fd, static_cast<off_t>(sizeof(h)) + whole) != 0) {
+      ::close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  JournalHeader h{};
+  std::memcpy(h.magic, kJournalMagic, sizeof(h.magic));
+  h.version = kJournalVersion;
+  h.header_size = sizeof(JournalHeader);
+  h.record_size = sizeof(JournalTrade);
+  h.symbol_count = static_cast<uint32_t>(symbols.size());
+  h.session_id = session_id;
+  for (size_t i = 0; i < symbols.size(); ++i) h.symbols[i] = symbols[i];
+  if (::write(fd, &h, sizeof(h)) != static_cast<ssize_t>(sizeof(h))) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+TradeJournalReader::~TradeJournalReader() {
+  if (base_) ::munmap(const_cast<unsigned char*>(base_), len_);
+}
+
+bool TradeJournalReader::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) { error_ = path + ": " + std::strerror(errno); return false; }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalHeader)) {
+    ::close(fd);
+    error_ = path + ": too short for a journal header";
+    return false;
+  }
+  len_ = static_cast<size_t>(st.st_size);
+  void* p = ::mmap(nullptr, len_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) { error_ = path + ": mmap failed"; len_ = 0; return false; }
+  base_ = static_cast<const unsigned char*>(p);
+  if (!valid_header(header())) { error_ = path + ": not a v1 trade journal"; return false; }
+
+  records_ = reinterpret_cast<const JournalTrade*>(base_ + sizeof(JournalHeader));
+  count_ = (len_ - sizeof(JournalHeader)) / sizeof(JournalTrade);
+  (void)::madvise(const_cast<unsigned char*>(base_), len_, MADV_SEQUENTIAL);
+  return true;
+}
+
+} // namespace ts
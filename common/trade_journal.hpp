@@ -0,0 +1,88 @@
+#pragma once
+#include "common/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+// Append-only binary trade journal: one fixed-size header followed by
+// fixed-width records, all little-endian, so readers can mmap the file and
+// index it directly. A partially written tail record is ignored.
+//
+//   [JournalHeader, 1024 bytes][JournalTrade, 88 bytes] * N
+
+constexpr char kJournalMagic[8] = {'T', 'S', 'T', 'R', 'A', 'D', 'E', 'S'};
+constexpr uint32_t kJournalVersion = 1;
+constexpr size_t kJournalMaxSymbols = 32;
+
+struct JournalSymbol {
+  char name[16];          // NUL-padded
+  double ticks_per_unit;  // px = ticks / ticks_per_unit, same as PriceScale::to_px
+};
+
+struct JournalHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;   // offset of the first record
+  uint32_t record_size;
+  uint32_t symbol_count;
+  uint64_t session_id;
+  uint8_t reserved0[32];
+  JournalSymbol symbols[kJournalMaxSymbols];
+  uint8_t reserved1[1024 - 64 - kJournalMaxSymbols * sizeof(JournalSymbol)];
+};
+static_assert(sizeof(JournalHeader) == 1024, "journal header layout");
+
+struct JournalTrade {
+  uint64_t ts_ns;
+  uint64_t maker_id;
+  uint64_t taker_id;
+  int64_t px;             // ticks of symbols[symbol]
+  int32_t qty;
+  uint16_t symbol;        // index into the header's symbol table
+  uint8_t maker_side;     // 0 = BUY, 1 = SELL
+  uint8_t taker_side;
+  char maker_client[24];  // NUL-padded, truncated
+  char taker_client[24];
+};
+static_assert(sizeof(JournalTrade) == 88, "journal record layout");
+
+// Create (or reopen and validate) a journal and return its fd for appends;
+// -1 on error. A new file gets a header built from the symbol table.
+int open_trade_journal(const std::string& path, uint64_t session_id,
+                       const std::vector<JournalSymbol>& symbols);
+
+// Read-only mmap view of a journal.
+class TradeJournalReader {
+public:
+  TradeJournalReader() = default;
+  ~TradeJournalReader();
+
+  TradeJournalReader(const TradeJournalReader&) = delete;
+  TradeJournalReader& operator=(const TradeJournalReader&) = delete;
+
+  // false (with error() set) if the file is missing, short, or not a v1 journal
+  bool open(const std::string& path);
+
+  const JournalHeader& header() const { return *reinterpret_cast<const JournalHeader*>(base_); }
+  size_t size() const { return count_; }
+  const JournalTrade& operator[](size_t i) const { return records_[i]; }
+  const JournalTrade* begin() const { return records_; }
+  const JournalTrade* end() const { return records_ + count_; }
+
+  double to_px(const JournalTrade& t) const {
+    return static_cast<double>(t.px) / header().symbols[t.symbol].ticks_per_unit;
+  }
+  const std::string& error() const { return error_; }
+
+private:
+  const unsigned char* base_{nullptr};
+  size_t len_{0};
+  const JournalTrade* records_{nullptr};
+  size_t count_{0};
+  std::string error_;
+};
+
+} // namespace ts
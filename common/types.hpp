@@ -1,5 +1,7 @@
 #pragma once
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -11,31 +13,93 @@ inline uint64_t now_ns() {
   return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
-enum class Side { Buy=0, Sell=1 };
+// calendar time (Unix epoch), for anything shown as a time of day
+inline uint64_t wall_ns() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+enum class Side : uint8_t { Buy=0, Sell=1 };
+
+// Prices are held as an integer number of ticks; 0 marks a MARKET order.
+using Price = int64_t;
+
+// Converts between decimal prices (wire/log format) and integer ticks.
+struct PriceScale {
+  double tick{0.01};
+  double ticks_per_unit{100.0};
+  int decimals{2};  // digits after the point that tell any two ticks apart
+
+  PriceScale() = default;
+  explicit PriceScale(double tick_size)
+      : tick(tick_size), ticks_per_unit(1.0 / tick_size), decimals(tick_decimals(tick_size)) {}
+
+  static int tick_decimals(double tick) {
+    int d = 0;
+    for (double t = tick; d < 9 && std::fabs(t - std::round(t)) > 1e-9 * std::fmax(1.0, t); t *= 10) ++d;
+    return d;
+  }
+
+  Price to_ticks(double px) const { return static_cast<Price>(std::llround(px * ticks_per_unit)); }
+  // to_ticks for prices a client gave: false when px is off the tick grid
+  // (beyond float noise), since rounding could move a limit past itself
+  bool on_grid(double px, Price& ticks) const {
+    ticks = to_ticks(px);
+    return std::fabs(px * ticks_per_unit - static_cast<double>(ticks)) < 1e-6;
+  }
+  // dividing (rather than multiplying by 'tick') keeps e.g. 1025 ticks == 10.25 exactly
+  double to_px(Price ticks) const { return static_cast<double>(ticks) / ticks_per_unit; }
+  // price text for the wire: exactly `decimals` digits, so every line shows a
+  // level the same way; `extra` more for values between ticks (mids, averages)
+  std::string format(double ticks, int extra = 0) const {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%.*f", decimals + extra, ticks / ticks_per_unit);
+    return buf;
+  }
+};
+
+// Interned client name; see ClientTable
+using ClientId = uint32_t;
+
+struct Order {
+  uint64_t id{0};
+  Price px{0};  // for LIMITs; 0 for MARKET while matching
+  int qty{0};
+  ClientId client{0};
+  Side side{Side::Buy};
+};
+static_assert(sizeof(Order) <= 32, "Order is copied per fill; keep it small");
 
 struct Trade {
   // Order IDs of the resting (maker) and incoming (taker) orders
   uint64_t maker_id{0};
   uint64_t taker_id{0};
+  Price px{0};  // ticks; see PriceScale
   int qty{0};
-  double px{0.0};
 
-  // NEW: attribution + direction
-  std::string maker_client;  // who provided liquidity
-  std::string taker_client;  // who took liquidity
+  // attribution + direction
+  ClientId maker_client{0};  // who provided liquidity
+  ClientId taker_client{0};  // who took liquidity
   Side maker_side{Side::Sell}; // if maker sold, taker bought (and vice versa)
   Side taker_side{Side::Buy};
 };
+static_assert(sizeof(Trade) <= 40, "Trade is copied per fill; keep it small");
 
-// Convenience: top-of-book snapshot
+// Convenience: top-of-book snapshot (prices in ticks)
 struct TopOfBook {
   bool has_bid{false};
-  double bid_px{0.0};
+  Price bid_px{0};
   int bid_qty{0};
   bool has_ask{false};
-  double ask_px{0.0};
+  Price ask_px{0};
   int ask_qty{0};
 };
 
-} // namespace ts
+// One aggregated price level of an L2 snapshot (prices in ticks)
+struct DepthLevel {
+  Price px{0};
+  int64_t qty{0};
+  uint32_t orders{0};
+};
 
+} // namespace ts
@@ -1,9 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
 
 namespace ts {
 
@@ -24,6 +28,74 @@ inline std::vector<std::string> tokens(const std::string& s) {
   return out;
 }
 
+// --- string_view variants for the command path: no copies, no allocation ---
+
+inline std::string_view trim_view(std::string_view s) {
+  size_t a = 0, b = s.size();
+  while (a < b && std::isspace(static_cast<unsigned char>(s[a]))) ++a;
+  while (b > a && std::isspace(static_cast<unsigned char>(s[b-1]))) --b;
+  return s.substr(a, b - a);
+}
+
+// Whitespace-separated views into a line the caller keeps alive.
+// Tokens past kMax are dropped (no command needs that many).
+struct TokenViews {
+  static constexpr size_t kMax = 16;
+  std::string_view tok[kMax];
+  size_t n{0};
+
+  size_t size() const { return n; }
+  bool empty() const { return n == 0; }
+  std::string_view operator[](size_t i) const { return tok[i]; }
+  void erase(size_t i, size_t count) {
+    for (size_t j = i + count; j < n; ++j) tok[j - count] = tok[j];
+    n -= count;
+  }
+};
+
+inline TokenViews token_views(std::string_view s) {
+  TokenViews out;
+  size_t i = 0;
+  while (i < s.size() && out.n < TokenViews::kMax) {
+    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+    size_t start = i;
+    while (i < s.size() && !std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+    if (i > start) out.tok[out.n++] = s.substr(start, i - start);
+  }
+  return out;
+}
+
+// Removes an optional "SYMBOL <name>" pair from the tokens and returns the
+// name ("" when absent), so the positional command grammar is unchanged.
+inline std::string_view take_symbol(TokenViews& toks) {
+  for (size_t i = 0; i + 1 < toks.size(); ++i) {
+    if (toks[i] == "SYMBOL") {
+      std::string_view sym = toks[i + 1];
+      toks.erase(i, 2);
+      return sym;
+    }
+  }
+  return {};
+}
+
+// Leading-number parses in the spirit of std::stoi/stoull/stod: trailing
+// junk is ignored, no digits at all is a failure.
+template <class Int>
+inline bool parse_int(std::string_view s, Int& out) {
+  auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+  return r.ec == std::errc() && r.ptr != s.data();
+}
+
+inline bool parse_double(std::string_view s, double& out) {
+  char buf[64];
+  if (s.empty() || s.size() >= sizeof(buf)) return false;
+  s.copy(buf, s.size());
+  buf[s.size()] = '\0';
+  char* end = nullptr;
+  out = std::strtod(buf, &end);
+  return end != buf;
+}
+
 // (Intentionally no now_ns() here; it lives in common/types.hpp)
 
 } // namespace ts
@@ -0,0 +1,85 @@
+#include "common/work_pool.hpp"
+
+namespace ts {
+
+WorkStealingPool::WorkStealingPool(size_t workers) {
+  if (workers == 0) workers = std::thread::hardware_concurrency();
+  if (workers == 0) workers = 1;
+  for (size_t i = 0; i < workers; ++i) workers_.push_back(std::make_unique<Worker>());
+  for (size_t i = 0; i < workers; ++i) workers_[i]->thread = std::thread([this, i] { loop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lk(idle_mu_);
+    stopping_.store(true);
+  }
+  work_cv_.notify_all();
+  for (auto& w : workers_) w->thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+  Worker& w = *workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+  unfinished_.fetch_add(1);
+  {
+    // counted before it is visible, so a taker never drives queued_ below zero
+    std::lock_guard<std::mutex> lk(idle_mu_);
+    queued_.fetch_add(1);
+  }
+  {
+    std::lock_guard<std::mutex> lk(w.mu);
+    w.tasks.push_back(std::move(task));
+  }
+  work_cv_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lk(idle_mu_);
+  done_cv_.wait(lk, [this] { return unfinished_.load() == 0; });
+}
+
+// own deque from the back, else another's from the front
+bool WorkStealingPool::take(size_t self, Task& out) {
+  {
+    Worker& w = *workers_[self];
+    std::lock_guard<std::mutex> lk(w.mu);
+    if (!w.tasks.empty()) {
+      out = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      return true;
+    }
+  }
+  for (size_t k = 1; k < workers_.size(); ++k) {
+    Worker& victim = *workers_[(self + k) % workers_.size()];
+    std::lock_guard<std::mutex> lk(victim.mu);
+    if (victim.tasks.empty()) continue;
+    out = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    workers_[self]->stolen.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::loop(size_t self) {
+  Task task;
+  while (true) {
+    if (take(self, task)) {
+      queued_.fetch_sub(1);
+      task(self);
+      task = nullptr;
+      workers_[self]->executed.fetch_add(1, std::memory_order_relaxed);
+      if (unfinished_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lk(idle_mu_);
+        done_cv_.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(idle_mu_);
+    work_cv_.wait(lk, [this] { return queued_.load() > 0 || stopping_.load(); });
+    if (stopping_.load() && queued_.load() == 0) return;
+  }
+}
+
+} // namespace ts
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ts {
+
+// Work-stealing thread pool for coarse, independent jobs (simulation runs).
+// Each worker owns a deque: it runs its own newest task first and, when
+// that is empty, steals the oldest task of another worker, so uneven jobs
+// still keep every core busy. Tasks get the worker index, which callers use
+// to pick per-worker state (allocators, scratch) without any sharing.
+class WorkStealingPool {
+public:
+  using Task = std::function<void(size_t worker)>;
+
+  explicit WorkStealingPool(size_t workers);  // 0: one per hardware thread
+  ~WorkStealingPool();                        // waits for everything submitted
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // any thread; tasks are dealt round-robin over the workers' deques
+  void submit(Task task);
+  void wait();  // until every task submitted so far has run
+
+  size_t workers() const { return workers_.size(); }
+  uint64_t executed(size_t worker) const { return workers_[worker]->executed.load(std::memory_order_relaxed); }
+  uint64_t stolen(size_t worker) const { return workers_[worker]->stolen.load(std::memory_order_relaxed); }
+
+private:
+  struct alignas(64) Worker {
+    std::mutex mu;
+    std::deque<Task> tasks;
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};  // tasks this worker took from another
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_{0};     // round-robin submit target
+  std::atomic<size_t> queued_{0};   // in some deque, not yet taken
+  std::atomic<size_t> unfinished_{0};
+  std::atomic<bool> stopping_{false};
+  std::mutex idle_mu_;
+  std::condition_variable work_cv_;  // workers park here when nothing is queued
+  std::condition_variable done_cv_;  // wait() parks here
+
+  void loop(size_t self);
+  bool take(size_t self, Task& out);
+};
+
+} // namespace ts
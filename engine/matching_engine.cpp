@@ -3,164 +3,236 @@
 
 namespace ts {
 
-MatchingEngine::MatchingEngine() {}
+MatchingEngine::MatchingEngine(double tick_size, size_t ladder_window, const PoolConfig& pool)
+    : scale_(tick_size), nodes_(pool.order_capacity, pool.huge_pages, pool.slabs),
+      bids_(Side::Buy, ladder_window), asks_(Side::Sell, ladder_window) {
+  touched_.reserve(64);
+}
+
+MatchingEngine::~MatchingEngine() {
+  index_.for_each([this](OrderNode* n) { nodes_.destroy(n); });
+}
 
-bool MatchingEngine::crosses(const Order& taker, double maker_px) {
+bool MatchingEngine::crosses(const Order& taker, Price maker_px) {
   if (taker.side == Side::Buy)  return taker.px >= maker_px;  // buy crosses ask
   else                          return taker.px <= maker_px;  // sell crosses bid
 }
 
 void MatchingEngine::add_resting(const Order& o) {
   if (o.qty <= 0) return;
+  OrderNode* n = nodes_.create();
+  static_cast<Order&>(*n) = o;
+  index_.insert(o.id, n);
+  if (o.client >= by_client_.size()) by_client_.resize(o.client + 1, nullptr);
+  n->client_prev = nullptr;
+  n->client_next = by_client_[o.client];
+  if (n->client_next) n->client_next->client_prev = n;
+  by_client_[o.client] = n;
+  touch(o.side, o.px);
   if (o.side == Side::Buy) {
-    bids_[o.px].push_back(o);
+    bids_.push_back(n);
   } else {
-    asks_[o.px].push_back(o);
+    asks_.push_back(n);
   }
 }
 
-std::vector<Trade> MatchingEngine::match_incoming(Order taker) {
-  std::vector<Trade> fills;
+void MatchingEngine::restore_resting(const Order& o) {
+  add_resting(o);
+  if (o.id >= next_id_) next_id_ = o.id + 1;
+}
 
+void MatchingEngine::retire(OrderNode* n) {
+  if (n->client_prev) n->client_prev->client_next = n->client_next;
+  else                by_client_[n->client] = n->client_next;
+  if (n->client_next) n->client_next->client_prev = n->client_prev;
+  index_.erase(n->id);
+  nodes_.destroy(n);
+}
+
+// Picks the instantiation once per order; the loop itself has no run-time
+// test of side or order type.
+void MatchingEngine::match_incoming(Order& taker, std::vector<Trade>& fills) {
+  fills.clear();
   if (taker.side == Side::Buy) {
-    // Buyer incoming; match against asks_
-    while (taker.qty > 0 && !asks_.empty()) {
-      auto it = asks_.begin();
-      double maker_px = it->first;
-      auto& q = it->second;
-
-      if (taker.px > 0.0 && maker_px > taker.px) break;
-      if (q.empty()) { asks_.erase(it); continue; }
-
-      Order maker = q.front();
-      int qty = std::min(taker.qty, maker.qty);
-      taker.qty -= qty;
-      maker.qty -= qty;
-
-      Trade tr;
-      tr.maker_id = maker.id;
-      tr.taker_id = taker.id;
-      tr.qty = qty;
-      tr.px = maker_px;
-      tr.maker_client = maker.client;
-      tr.taker_client = taker.client;
-      tr.maker_side = maker.side;
-      tr.taker_side = taker.side;
-      fills.push_back(tr);
-
-      if (maker.qty == 0) {
-        q.pop_front();
-        if (q.empty()) asks_.erase(it);
-      } else {
-        q.front() = maker;
-      }
-    }
+    if (taker.px > 0) match<Side::Buy, true>(taker, fills);
+    else              match<Side::Buy, false>(taker, fills);
   } else {
-    // Seller incoming; match against bids_
-    while (taker.qty > 0 && !bids_.empty()) {
-      auto it = bids_.begin();
-      double maker_px = it->first;
-      auto& q = it->second;
-
-      if (taker.px > 0.0 && maker_px < taker.px) break;
-      if (q.empty()) { bids_.erase(it); continue; }
-
-      Order maker = q.front();
-      int qty = std::min(taker.qty, maker.qty);
-      taker.qty -= qty;
-      maker.qty -= qty;
-
-      Trade tr;
-      tr.maker_id = maker.id;
-      tr.taker_id = taker.id;
-      tr.qty = qty;
-      tr.px = maker_px;
-      tr.maker_client = maker.client;
-      tr.taker_client = taker.client;
-      tr.maker_side = maker.side;
-      tr.taker_side = taker.side;
-      fills.push_back(tr);
-
-      if (maker.qty == 0) {
-        q.pop_front();
-        if (q.empty()) bids_.erase(it);
-      } else {
-        q.front() = maker;
-      }
-    }
+    if (taker.px > 0) match<Side::Sell, true>(taker, fills);
+    else              match<Side::Sell, false>(taker, fills);
   }
+}
 
-  return fills;
+template <Side S, bool Limit>
+void MatchingEngine::match(Order& taker, std::vector<Trade>& fills) {
+  // a buyer takes from the asks, a seller from the bids
+  PriceLadder& book = S == Side::Buy ? asks_ : bids_;
+  constexpr Side maker_side = S == Side::Buy ? Side::Sell : Side::Buy;
+
+  while (taker.qty > 0 && !book.empty()) {
+    Price maker_px = book.best_px();
+    if constexpr (Limit) {
+      if (S == Side::Buy ? maker_px > taker.px : maker_px < taker.px) break;
+    }
+
+    auto& q = book.best_level();
+    Order& maker = q.front();
+    touch(maker_side, maker_px);
+    int qty = std::min(taker.qty, maker.qty);
+    taker.qty -= qty;
+    maker.qty -= qty;
+    q.total_qty -= qty;
+
+    Trade tr;
+    tr.maker_id = maker.id;
+    tr.taker_id = taker.id;
+    tr.qty = qty;
+    tr.px = maker_px;
+    tr.maker_client = maker.client;
+    tr.taker_client = taker.client;
+    tr.maker_side = maker_side;
+    tr.taker_side = S;
+    fills.push_back(tr);
+
+    if (maker.qty == 0) {
+      retire(q.pop_front());
+      if (q.empty()) book.pop_best();
+    }
+  }
 }
 
-std::vector<Trade> MatchingEngine::new_market_order(const std::string& client, Side side, int qty) {
+bool MatchingEngine::new_market_order(ClientId client, Side side, int qty, std::vector<Trade>& fills) {
+  touched_.clear();
+  fills.clear();
   Order taker;
   taker.id = next_id_++;
   taker.client = client;
   taker.side = side;
   taker.qty = qty;
-  taker.px = 0.0; // 0 ==> MARKET (no price constraint)
-  return match_incoming(taker);
+  taker.px = 0; // 0 ==> MARKET (no price constraint)
+  if (taker.qty <= 0) return false;
+  match_incoming(taker, fills);
+  return true;
+}
+
+std::vector<Trade> MatchingEngine::new_market_order(ClientId client, Side side, int qty) {
+  std::vector<Trade> fills;
+  new_market_order(client, side, qty, fills);
+  return fills;
 }
 
-std::vector<Trade> MatchingEngine::new_limit_order(const std::string& client, Side side, int qty, double px) {
+bool MatchingEngine::new_limit_order(ClientId client, Side side, int qty, double px, std::vector<Trade>& fills) {
+  touched_.clear();
+  fills.clear();
   Order taker;
   taker.id = next_id_++;
   taker.client = client;
   taker.side = side;
   taker.qty = qty;
-  taker.px = px;
+  // off the grid, or below one tick (which would read as MARKET)
+  if (taker.qty <= 0 || !scale_.on_grid(px, taker.px) || taker.px <= 0) return false;
 
-  auto fills = match_incoming(taker);
+  match_incoming(taker, fills);
   if (taker.qty > 0) {
     // remaining becomes maker (resting)
     add_resting(taker);
   }
+  return true;
+}
+
+std::vector<Trade> MatchingEngine::new_limit_order(ClientId client, Side side, int qty, double px) {
+  std::vector<Trade> fills;
+  new_limit_order(client, side, qty, px, fills);
   return fills;
 }
 
+void MatchingEngine::remove_resting(OrderNode* n) {
+  touch(n->side, n->px);
+  if (n->side == Side::Buy) bids_.remove(n);
+  else                      asks_.remove(n);
+  retire(n);
+}
+
 bool MatchingEngine::cancel(uint64_t order_id) {
-  // try bids
-  for (auto it = bids_.begin(); it != bids_.end(); ++it) {
-    auto& dq = it->second;
-    for (auto dit = dq.begin(); dit != dq.end(); ++dit) {
-      if (dit->id == order_id) {
-        dq.erase(dit);
-        if (dq.empty()) bids_.erase(it);
-        return true;
-      }
-    }
+  touched_.clear();
+  OrderNode* n = index_.find(order_id);
+  if (!n) return false;
+  remove_resting(n);
+  return true;
+}
+
+size_t MatchingEngine::cancel_all(ClientId client) {
+  touched_.clear();
+  size_t n = 0;
+  while (client < by_client_.size() && by_client_[client]) {
+    remove_resting(by_client_[client]);
+    ++n;
   }
-  // try asks
-  for (auto it = asks_.begin(); it != asks_.end(); ++it) {
-    auto& dq = it->second;
-    for (auto dit = dq.begin(); dit != dq.end(); ++dit) {
-      if (dit->id == order_id) {
-        dq.erase(dit);
-        if (dq.empty()) asks_.erase(it);
-        return true;
-      }
-    }
+  return n;
+}
+
+ReplaceResult MatchingEngine::replace(uint64_t order_id, int qty, double px, std::vector<Trade>& fills) {
+  touched_.clear();
+  fills.clear();
+  OrderNode* n = index_.find(order_id);
+  if (!n) return ReplaceResult::NotFound;
+  Price p = 0;
+  if (qty <= 0 || !scale_.on_grid(px, p) || p <= 0) return ReplaceResult::Rejected;
+
+  PriceLadder& book = n->side == Side::Buy ? bids_ : asks_;
+  touch(n->side, n->px);
+  if (p == n->px && qty <= n->qty) {
+    book.reduce(n, n->qty - qty);
+    return ReplaceResult::Amended;
+  }
+
+  // out of the queue, then in again like a new order under the same id
+  book.remove(n);
+  Order taker = *n;
+  taker.qty = qty;
+  taker.px = p;
+  match_incoming(taker, fills);
+  if (taker.qty == 0) {
+    retire(n);
+    return ReplaceResult::Requeued;
   }
-  return false;
+  n->qty = taker.qty;
+  n->px = p;
+  touch(n->side, p);
+  book.push_back(n);
+  return ReplaceResult::Requeued;
 }
 
 TopOfBook MatchingEngine::top() const {
   TopOfBook t;
   if (!bids_.empty()) {
     t.has_bid = true;
-    t.bid_px  = bids_.begin()->first;
-    int sum = 0; for (auto &o : bids_.begin()->second) sum += o.qty;
-    t.bid_qty = sum;
+    t.bid_px  = bids_.best_px();
+    t.bid_qty = static_cast<int>(bids_.best_level().total_qty);
   }
   if (!asks_.empty()) {
     t.has_ask = true;
-    t.ask_px  = asks_.begin()->first;
-    int sum = 0; for (auto &o : asks_.begin()->second) sum += o.qty;
-    t.ask_qty = sum;
+    t.ask_px  = asks_.best_px();
+    t.ask_qty = static_cast<int>(asks_.best_level().total_qty);
   }
   return t;
 }
 
+DepthLevel MatchingEngine::level(Side side, Price px) const {
+  const PriceLevel* l = (side == Side::Buy ? bids_ : asks_).find(px);
+  return l ? DepthLevel{px, l->total_qty, l->orders} : DepthLevel{px, 0, 0};
+}
+
+void MatchingEngine::depth(size_t n, std::vector<DepthLevel>& bids, std::vector<DepthLevel>& asks) const {
+  auto collect = [n](const PriceLadder& book, std::vector<DepthLevel>& out) {
+    out.clear();
+    book.visit(n, [&out](Price px, const PriceLevel& lvl) {
+      out.push_back(DepthLevel{px, lvl.total_qty, lvl.orders});
+      return true;
+    });
+  };
+  collect(bids_, bids);
+  collect(asks_, asks);
+}
+
 } // namespace ts
 
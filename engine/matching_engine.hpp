@@ -1,49 +1,136 @@
 #pragma once
 #include "common/types.hpp"
-#include <deque>
-#include <map>
+#include "engine/order_index.hpp"
+#include "engine/pool.hpp"
+#include "engine/price_ladder.hpp"
 #include <string>
 #include <vector>
 #include <cstdint>
 
 namespace ts {
 
-struct Order {
-  uint64_t id{0};
-  std::string client;
-  Side side{Side::Buy};
-  int qty{0};
-  double px{0.0};  // for LIMITs; ignored for MARKET while matching
+// Outcome of MatchingEngine::replace
+enum class ReplaceResult : uint8_t {
+  NotFound,  // no such resting order
+  Rejected,  // qty <= 0, price off the tick grid or below one tick; order unchanged
+  Amended,   // same price, smaller qty: reduced in place, queue position kept
+  Requeued,  // re-entered at the new price/qty (may trade), behind the level
+};
+
+// A price level whose aggregate changed during the last engine call
+struct LevelRef {
+  Side side;
+  Price px;
 };
 
 class MatchingEngine {
 public:
-  MatchingEngine();
+  // tick_size: minimum price increment; ladder_window: number of ticks per
+  // side kept in the array-indexed part of the book around the current price;
+  // pool: preallocated storage for resting orders
+  explicit MatchingEngine(double tick_size = 0.01, size_t ladder_window = 4096,
+                          const PoolConfig& pool = {});
+  ~MatchingEngine();
+
+  // resting orders live in the engine's node pool
+  MatchingEngine(const MatchingEngine&) = delete;
+  MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+  // client is an id from the session's ClientTable. The overloads taking
+  // 'fills' clear and refill it, so a reused vector keeps matching off the heap.
 
-  // place a resting limit order; returns any trades executed immediately
-  std::vector<Trade> new_limit_order(const std::string& client, Side side, int qty, double px);
+  // place a resting limit order; fills are the trades executed immediately.
+  // false (nothing done, the id is still used up) for qty <= 0 or a price
+  // off the tick grid or under one tick; market orders likewise for qty <= 0
+  bool new_limit_order(ClientId client, Side side, int qty, double px, std::vector<Trade>& fills);
+  std::vector<Trade> new_limit_order(ClientId client, Side side, int qty, double px);
 
-  // execute a market order against the book; returns fills
-  std::vector<Trade> new_market_order(const std::string& client, Side side, int qty);
+  // execute a market order against the book
+  bool new_market_order(ClientId client, Side side, int qty, std::vector<Trade>& fills);
+  std::vector<Trade> new_market_order(ClientId client, Side side, int qty);
 
-  // cancel a previously resting order by id
+  // cancel a previously resting order by id (O(1))
   bool cancel(uint64_t order_id);
 
-  // top-of-book summary
+  // change a resting order's open qty and price, keeping its id. Only a
+  // pure size decrease keeps queue priority; anything else re-enters the
+  // order as if new (crossing the book first), so fills may result.
+  ReplaceResult replace(uint64_t order_id, int qty, double px, std::vector<Trade>& fills);
+
+  // cancel every resting order of client; O(that client's orders)
+  size_t cancel_all(ClientId client);
+
+  // top-of-book summary (O(1): level totals are maintained incrementally)
   TopOfBook top() const;
 
+  // L2 snapshot of up to n levels per side, best first. The vectors are
+  // cleared and refilled so callers can reuse their storage.
+  void depth(size_t n, std::vector<DepthLevel>& bids, std::vector<DepthLevel>& asks) const;
+
+  // aggregate at one price (qty 0 / orders 0 once the level is gone)
+  DepthLevel level(Side side, Price px) const;
+
+  // levels touched by the most recent new_*_order/cancel call, in the order
+  // they changed; reset at the start of every such call
+  const std::vector<LevelRef>& touched() const { return touched_; }
+
+  // tick size / price conversion used for every price the engine reports
+  const PriceScale& scale() const { return scale_; }
+
+  // --- snapshots (see net/recovery.hpp) ---
+  // every resting order, bids then asks, each best level first and in queue order
+  template <class F>
+  void for_each_resting(F&& f) const;
+  // rest o as-is (id, client, qty) behind the orders already at its price;
+  // no matching, so only for rebuilding a book that was consistent
+  void restore_resting(const Order& o);
+  uint64_t next_order_id() const { return next_id_; }
+  void set_next_order_id(uint64_t id) { next_id_ = id; }
+  size_t resting_count() const { return index_.size(); }
+  size_t levels(Side side) const { return side == Side::Buy ? bids_.levels() : asks_.levels(); }
+
 private:
   uint64_t next_id_{1};
+  PriceScale scale_;
+  ObjectPool<OrderNode> nodes_;  // resting orders (declared before the ladders that link them)
+
+  // best bid = highest price; best ask = lowest price
+  PriceLadder bids_;
+  PriceLadder asks_;
 
-  // price->queue (best bid = highest price; best ask = lowest price)
-  std::map<double, std::deque<Order>, std::greater<double>> bids_;
-  std::map<double, std::deque<Order>, std::less<double>> asks_;
+  // id -> resting order node, for O(1) cancel
+  OrderIndex index_;
+
+  // client id -> newest resting order, linked through client_next
+  std::vector<OrderNode*> by_client_;
+
+  std::vector<LevelRef> touched_;
+  void touch(Side side, Price px) {
+    if (touched_.empty() || touched_.back().px != px || touched_.back().side != side)
+      touched_.push_back(LevelRef{side, px});
+  }
 
   // internal helpers
-  std::vector<Trade> match_incoming(Order taker); // for both market and limit that crosses
-  void add_resting(const Order& o);               // enqueue remaining qty
-  static bool crosses(const Order& taker, double maker_px);
+  void match_incoming(Order& taker, std::vector<Trade>& fills); // market and crossing limit
+  // the matching loop for a taker on side S; Limit: stop at taker.px
+  template <Side S, bool Limit>
+  void match(Order& taker, std::vector<Trade>& fills);
+  void add_resting(const Order& o);                // enqueue remaining qty
+  void retire(OrderNode* n);                       // drop a filled/cancelled node
+  void remove_resting(OrderNode* n);               // cancel: unlink from the book, retire
+  static bool crosses(const Order& taker, Price maker_px);
 };
 
-} // namespace ts
+template <class F>
+void MatchingEngine::for_each_resting(F&& f) const {
+  auto walk = [&f](const PriceLadder& side) {
+    side.visit(side.levels(), [&f](Price, const PriceLevel& lvl) {
+      for (const OrderNode* n = lvl.head; n; n = n->next) f(static_cast<const Order&>(*n));
+      return true;
+    });
+  };
+  walk(bids_);
+  walk(asks_);
+}
 
+} // namespace ts
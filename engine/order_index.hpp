@@ -0,0 +1,82 @@
+#pragma once
+#include "engine/price_ladder.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ts {
+
+// Order id -> resting node. MatchingEngine hands out ids densely, so this is
+// a direct-mapped table split into fixed-size pages instead of a hash map:
+// lookups are two array indexations and neighbouring ids share cache lines.
+// A page is recycled once every order on it has left the book (the newest
+// page is kept so a busy frontier does not churn), and new pages come from
+// the recycled ones first, so a steady flow of orders allocates nothing.
+class OrderIndex {
+public:
+  // room for this many page pointers (kPageBits ids each) before the table grows
+  explicit OrderIndex(size_t reserve_pages = 1 << 12) {
+    pages_.reserve(reserve_pages);
+    spare_.reserve(kMaxSpare);
+  }
+
+  OrderNode* find(uint64_t id) const {
+    size_t p = id >> kPageBits;
+    if (p >= pages_.size() || !pages_[p]) return nullptr;
+    return pages_[p]->slots[id & kPageMask];
+  }
+
+  void insert(uint64_t id, OrderNode* n) {
+    size_t p = id >> kPageBits;
+    if (p >= pages_.size()) pages_.resize(p + 1);
+    if (!pages_[p]) {
+      if (spare_.empty()) {
+        pages_[p] = std::make_unique<Page>();
+      } else {
+        pages_[p] = std::move(spare_.back());
+        spare_.pop_back();
+      }
+    }
+    pages_[p]->slots[id & kPageMask] = n;
+    ++pages_[p]->live;
+    ++size_;
+  }
+
+  // id must currently be present
+  void erase(uint64_t id) {
+    size_t p = id >> kPageBits;
+    Page& pg = *pages_[p];
+    pg.slots[id & kPageMask] = nullptr;
+    --size_;
+    if (--pg.live > 0 || p + 1 == pages_.size()) return;
+    if (spare_.size() < kMaxSpare) spare_.push_back(std::move(pages_[p]));  // slots all null again
+    else                           pages_[p].reset();
+  }
+
+  size_t size() const { return size_; }
+
+  template <class F>
+  void for_each(F f) const {
+    for (const auto& pg : pages_) {
+      if (!pg) continue;
+      for (OrderNode* n : pg->slots) if (n) f(n);
+    }
+  }
+
+private:
+  static constexpr unsigned kPageBits = 10;
+  static constexpr uint64_t kPageMask = (uint64_t{1} << kPageBits) - 1;
+  static constexpr size_t kMaxSpare = 4;
+
+  struct Page {
+    std::array<OrderNode*, size_t{1} << kPageBits> slots{};
+    uint32_t live{0};
+  };
+
+  std::vector<std::unique_ptr<Page>> pages_;
+  std::vector<std::unique_ptr<Page>> spare_;  // emptied pages kept for reuse
+  size_t size_{0};
+};
+
+} // namespace ts
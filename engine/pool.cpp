@@ -0,0 +1,55 @@
+#include "engine/pool.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ts {
+
+static size_t round_up(size_t bytes, size_t to) { return (bytes + to - 1) / to * to; }
+
+void* slab_alloc(size_t bytes, bool huge, size_t& mapped) {
+  void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (huge) {
+    // explicit huge pages need a reserved pool (vm.nr_hugepages); fall back quietly
+    size_t len = round_up(bytes, size_t{2} << 20);
+    p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) { mapped = len; return p; }
+  }
+#endif
+  size_t len = round_up(bytes, static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+  p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+  if (huge) (void)::madvise(p, len, MADV_HUGEPAGE);
+#endif
+  mapped = len;
+  return p;
+}
+
+void slab_free(void* p, size_t mapped) {
+  if (p) (void)::munmap(p, mapped);
+}
+
+SlabCache::~SlabCache() {
+  for (auto& s : free_) slab_free(s.first, s.second);
+}
+
+void* SlabCache::take(size_t bytes, bool huge, size_t& mapped) {
+  // pools of one configuration ask for the same size: the first fit is it
+  for (size_t i = 0; i < free_.size(); ++i) {
+    if (free_[i].second < bytes) continue;
+    void* p = free_[i].first;
+    mapped = free_[i].second;
+    free_[i] = free_.back();
+    free_.pop_back();
+    ++reused_;
+    return p;
+  }
+  return slab_alloc(bytes, huge, mapped);
+}
+
+void SlabCache::give(void* p, size_t mapped) {
+  if (p) free_.emplace_back(p, mapped);
+}
+
+} // namespace ts
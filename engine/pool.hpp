@@ -0,0 +1,184 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+class SlabCache;
+
+struct PoolConfig {
+  size_t order_capacity{1 << 16};  // resting orders preallocated per engine
+  bool huge_pages{false};          // back the slabs with huge pages if the OS allows
+  SlabCache* slabs{nullptr};       // take/return slabs here instead of the OS
+};
+
+// Page-aligned raw memory for pools. With huge=true it tries explicit huge
+// pages, then transparent ones (Linux), then plain pages. 'mapped' receives
+// the length to hand back to slab_free.
+void* slab_alloc(size_t bytes, bool huge, size_t& mapped);
+void slab_free(void* p, size_t mapped);
+
+// Slabs kept for reuse instead of being unmapped, for engines created and
+// destroyed over and over (simulation runs): no mmap/munmap per engine and
+// none of the TLB shootdowns an munmap sends to the process's other threads.
+// Not thread-safe: one per thread, outliving every pool that uses it.
+class SlabCache {
+public:
+  SlabCache() = default;
+  ~SlabCache();  // unmaps every slab kept
+
+  SlabCache(const SlabCache&) = delete;
+  SlabCache& operator=(const SlabCache&) = delete;
+
+  // a kept slab of at least bytes (contents undefined), else a new one
+  void* take(size_t bytes, bool huge, size_t& mapped);
+  void give(void* p, size_t mapped);
+
+  size_t kept() const { return free_.size(); }
+  uint64_t reused() const { return reused_; }
+
+private:
+  std::vector<std::pair<void*, size_t>> free_;  // base, mapped length
+  uint64_t reused_{0};
+};
+
+// Fixed-size object pool: slabs of T carved into a free list. The first slab
+// holds 'capacity' objects; running out adds another slab of the same size
+// rather than failing, so capacity is a sizing hint, not a hard limit.
+// Memory goes back to the OS only when the pool is destroyed.
+template <class T>
+class ObjectPool {
+public:
+  explicit ObjectPool(size_t capacity = 1024, bool huge_pages = false, SlabCache* cache = nullptr)
+      : slab_objs_(capacity ? capacity : 1), huge_(huge_pages), cache_(cache) {
+    slabs_.reserve(16);
+    grow();
+  }
+  ~ObjectPool() {
+    for (auto& s : slabs_) {
+      if (cache_) cache_->give(s.first, s.second);
+      else slab_free(s.first, s.second);
+    }
+  }
+
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  template <class... Args>
+  T* create(Args&&... args) {
+    if (!free_) grow();
+    Cell* c = free_;
+    free_ = c->next;
+    ++live_;
+    return ::new (static_cast<void*>(c)) T(std::forward<Args>(args)...);
+  }
+
+  void destroy(T* p) {
+    p->~T();
+    Cell* c = reinterpret_cast<Cell*>(p);
+    c->next = free_;
+    free_ = c;
+    --live_;
+  }
+
+  size_t live() const { return live_; }
+  size_t capacity() const { return slabs_.size() * slab_objs_; }
+
+private:
+  union Cell {
+    Cell* next;
+    alignas(T) unsigned char obj[sizeof(T)];
+  };
+
+  size_t slab_objs_;
+  bool huge_;
+  SlabCache* cache_;
+  std::vector<std::pair<void*, size_t>> slabs_;  // base, mapped length
+  Cell* free_{nullptr};
+  size_t live_{0};
+
+  void grow() {
+    size_t mapped = 0;
+    size_t bytes = slab_objs_ * sizeof(Cell);
+    Cell* slab = static_cast<Cell*>(cache_ ? cache_->take(bytes, huge_, mapped) : slab_alloc(bytes, huge_, mapped));
+    if (!slab) throw std::bad_alloc();
+    slabs_.emplace_back(slab, mapped);
+    // thread back to front so objects are handed out in address order
+    for (size_t i = slab_objs_; i-- > 0;) {
+      slab[i].next = free_;
+      free_ = &slab[i];
+    }
+  }
+};
+
+// Recycles single-node allocations of a node-based container (std::map), so
+// levels that come and go stop hitting the heap once the list is warm.
+// Bulk requests and a second node size fall through to operator new.
+class NodeFreeList {
+public:
+  NodeFreeList() = default;
+  ~NodeFreeList() {
+    while (head_) {
+      Link* n = head_->next;
+      ::operator delete(head_);
+      head_ = n;
+    }
+  }
+  NodeFreeList(const NodeFreeList&) = delete;
+  NodeFreeList& operator=(const NodeFreeList&) = delete;
+
+  void* allocate(size_t bytes) {
+    if (block_ == 0) block_ = bytes < sizeof(Link) ? sizeof(Link) : bytes;
+    if (bytes <= block_ && head_) {
+      Link* n = head_;
+      head_ = n->next;
+      return n;
+    }
+    return ::operator new(bytes <= block_ ? block_ : bytes);
+  }
+
+  void deallocate(void* p, size_t bytes) {
+    if (bytes > block_) { ::operator delete(p); return; }
+    Link* n = static_cast<Link*>(p);
+    n->next = head_;
+    head_ = n;
+  }
+
+private:
+  struct Link { Link* next; };
+  Link* head_{nullptr};
+  size_t block_{0};
+};
+
+template <class T>
+class NodeAllocator {
+public:
+  using value_type = T;
+
+  explicit NodeAllocator(NodeFreeList* list) : list_(list) {}
+  template <class U>
+  NodeAllocator(const NodeAllocator<U>& o) : list_(o.list_) {}
+
+  T* allocate(size_t n) {
+    if (n == 1) return static_cast<T*>(list_->allocate(sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    if (n == 1) list_->deallocate(p, sizeof(T));
+    else        ::operator delete(p);
+  }
+
+  template <class U>
+  bool operator==(const NodeAllocator<U>& o) const { return list_ == o.list_; }
+  template <class U>
+  bool operator!=(const NodeAllocator<U>& o) const { return list_ != o.list_; }
+
+private:
+  template <class U> friend class NodeAllocator;
+  NodeFreeList* list_;
+};
+
+} // namespace ts
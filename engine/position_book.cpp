@@ -0,0 +1,43 @@
+#include "engine/position_book.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace ts {
+
+Position& PositionBook::at(ClientId client) {
+  if (client >= by_client_.size()) by_client_.resize(static_cast<size_t>(client) + 1);
+  return by_client_[client];
+}
+
+void PositionBook::restore(ClientId client, const Position& p) { at(client) = p; }
+
+void PositionBook::on_fill(const Trade& t) {
+  apply(t.maker_client, t.maker_side, t.qty, t.px);
+  apply(t.taker_client, t.taker_side, t.qty, t.px);
+  last_px_ = t.px;
+}
+
+void PositionBook::apply(ClientId client, Side side, int qty, Price px) {
+  Position& p = at(client);
+  int64_t q = side == Side::Buy ? qty : -qty;
+  p.cash -= q * px;
+  p.volume += static_cast<uint64_t>(qty);
+  ++p.fills;
+
+  if (p.qty != 0 && (p.qty > 0) != (q > 0)) {
+    // closing (part of) the position: realize against its average cost
+    int64_t open = std::abs(p.qty);
+    int64_t closed = std::min(std::abs(q), open);
+    // open_cost * closed / open without overflowing the product
+    int64_t basis = p.open_cost / open * closed + p.open_cost % open * closed / open;
+    p.realized += (p.qty > 0 ? closed : -closed) * px - basis;
+    p.open_cost -= basis;
+    p.qty += q > 0 ? closed : -closed;
+    q += q > 0 ? -closed : closed;
+  }
+  // opening or adding (what is left after a flip)
+  p.open_cost += q * px;
+  p.qty += q;
+}
+
+} // namespace ts
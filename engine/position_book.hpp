@@ -0,0 +1,57 @@
+#pragma once
+#include "common/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts {
+
+// One client's account on one instrument. Money is kept in ticks * shares,
+// so every update is exact integer arithmetic; PriceScale::to_px converts.
+struct Position {
+  int64_t qty{0};        // signed: long > 0
+  int64_t cash{0};       // received for sales minus paid for buys
+  int64_t open_cost{0};  // average-cost basis of qty, signed like qty
+  int64_t realized{0};   // closed out against open_cost
+  uint64_t volume{0};    // shares traded
+  uint64_t fills{0};
+
+  // marked to mark (ticks, may fall between two, e.g. a mid): open
+  // position value minus its cost basis
+  double unrealized(double mark) const { return static_cast<double>(qty) * mark - static_cast<double>(open_cost); }
+  double pnl(double mark) const { return static_cast<double>(realized) + unrealized(mark); }
+};
+
+// Running positions for every client on one book, fed each fill as it
+// happens: O(1) per fill, indexed by ClientId like the engine's own
+// per-client order lists. Single-threaded, like the engine it follows.
+class PositionBook {
+public:
+  void on_fill(const Trade& t);
+
+  // nullptr for a client that never traded here
+  const Position* find(ClientId client) const {
+    return client < by_client_.size() && by_client_[client].fills ? &by_client_[client] : nullptr;
+  }
+  Price last_px() const { return last_px_; }  // last fill price, 0 before the first
+
+  // f(ClientId, const Position&) for every client that traded
+  template <class F>
+  void for_each(F&& f) const {
+    for (size_t i = 0; i < by_client_.size(); ++i)
+      if (by_client_[i].fills) f(static_cast<ClientId>(i), by_client_[i]);
+  }
+
+  // snapshots
+  void restore(ClientId client, const Position& p);
+  void set_last_px(Price px) { last_px_ = px; }
+
+private:
+  std::vector<Position> by_client_;
+  Price last_px_{0};
+
+  Position& at(ClientId client);
+  void apply(ClientId client, Side side, int qty, Price px);
+};
+
+} // namespace ts
@@ -0,0 +1,165 @@
+#include "engine/price_ladder.hpp"
+#include <utility>
+
+namespace ts {
+
+void PriceLevel::push_back(OrderNode* n) {
+  n->prev = tail;
+  n->next = nullptr;
+  if (tail) tail->next = n;
+  else      head = n;
+  tail = n;
+  total_qty += n->qty;
+  ++orders;
+}
+
+void PriceLevel::unlink(OrderNode* n) {
+  if (n->prev) n->prev->next = n->next;
+  else         head = n->next;
+  if (n->next) n->next->prev = n->prev;
+  else         tail = n->prev;
+  n->prev = n->next = nullptr;
+  total_qty -= n->qty;
+  --orders;
+}
+
+PriceLadder::PriceLadder(Side side, size_t window)
+    : side_(side), window_(window < 64 ? 64 : (window + 63) / 64 * 64),
+      far_(std::less<Price>(), decltype(far_)::allocator_type(&far_nodes_)) {
+  window_levels_.resize(window_);
+  occupied_.assign(window_ / 64, 0);
+}
+
+PriceLevel* PriceLadder::slot(Price px) {
+  if (in_window(px)) return &window_levels_[static_cast<size_t>(px - base_)];
+  auto it = far_.find(px);
+  return it == far_.end() ? nullptr : &it->second;
+}
+
+const PriceLevel* PriceLadder::slot(Price px) const {
+  if (in_window(px)) return &window_levels_[static_cast<size_t>(px - base_)];
+  auto it = far_.find(px);
+  return it == far_.end() ? nullptr : &it->second;
+}
+
+void PriceLadder::set_bit(size_t i, bool on) {
+  uint64_t bit = uint64_t{1} << (i & 63);
+  if (on) occupied_[i >> 6] |= bit;
+  else    occupied_[i >> 6] &= ~bit;
+}
+
+long PriceLadder::scan_down(size_t from) const {
+  size_t w = from >> 6;
+  unsigned b = from & 63;
+  uint64_t word = occupied_[w] & (b == 63 ? ~uint64_t{0} : ((uint64_t{1} << (b + 1)) - 1));
+  while (true) {
+    if (word) return static_cast<long>(w * 64 + 63 - __builtin_clzll(word));
+    if (w == 0) return -1;
+    word = occupied_[--w];
+  }
+}
+
+long PriceLadder::scan_up(size_t from) const {
+  size_t w = from >> 6;
+  uint64_t word = occupied_[w] & (~uint64_t{0} << (from & 63));
+  while (true) {
+    if (word) return static_cast<long>(w * 64 + __builtin_ctzll(word));
+    if (++w == occupied_.size()) return -1;
+    word = occupied_[w];
+  }
+}
+
+void PriceLadder::push_back(OrderNode* n) {
+  const Price px = n->px;
+  if (levels_ == 0) recenter(px);
+
+  PriceLevel* lvl;
+  bool inside = in_window(px);
+  if (inside) lvl = &window_levels_[static_cast<size_t>(px - base_)];
+  else        lvl = &far_[px];
+
+  if (lvl->empty()) {
+    if (inside) { set_bit(static_cast<size_t>(px - base_), true); ++window_count_; }
+    if (levels_++ == 0 || better(px, best_)) best_ = px;
+  }
+  lvl->push_back(n);
+  track_best();
+}
+
+void PriceLadder::remove(OrderNode* n) {
+  const Price px = n->px;
+  PriceLevel* lvl = slot(px);
+  lvl->unlink(n);
+  if (lvl->empty()) release(px);
+}
+
+void PriceLadder::release(Price px) {
+  if (in_window(px)) { set_bit(static_cast<size_t>(px - base_), false); --window_count_; }
+  else               far_.erase(px);
+
+  if (--levels_ == 0) return;
+  if (px == best_) best_ = next_best();
+  // keep the hot end of the book in the array: once the window runs dry,
+  // move it onto the new best and pull the nearby sparse levels into it
+  if (window_count_ == 0) recenter(best_);
+  else track_best();
+}
+
+Price PriceLadder::next_best() const {
+  // every remaining level is worse than the old best_, so scan away from it
+  bool found = false;
+  Price px = 0;
+  if (window_count_ > 0) {
+    long i;
+    if (side_ == Side::Buy) i = scan_down(best_ >= base_ + static_cast<Price>(window_) ? window_ - 1 : static_cast<size_t>(best_ - base_));
+    else                    i = scan_up(best_ < base_ ? 0 : static_cast<size_t>(best_ - base_));
+    if (i >= 0) { px = base_ + i; found = true; }
+  }
+  if (!far_.empty()) {
+    Price f = (side_ == Side::Buy) ? far_.rbegin()->first : far_.begin()->first;
+    if (!found || better(f, px)) px = f;
+  }
+  return px;
+}
+
+// Moving the window costs about one map operation per occupied level it
+// holds, so it follows a best that left it only once that many book changes
+// went through the map: one aggressive order leaves it in place, a market
+// that drifted away (past stale orders at the old price) takes it along.
+void PriceLadder::track_best() {
+  if (in_window(best_)) far_best_ = 0;
+  else if (++far_best_ > window_count_) recenter(best_);
+}
+
+// O(window / 64 + occupied levels); only levels crossing the window edge
+// touch the map
+void PriceLadder::recenter(Price mid) {
+  far_best_ = 0;
+  moving_.clear();
+  for (long i = window_count_ ? scan_up(0) : -1; i >= 0;
+       i = (static_cast<size_t>(i) + 1 < window_) ? scan_up(static_cast<size_t>(i) + 1) : -1) {
+    PriceLevel& l = window_levels_[static_cast<size_t>(i)];
+    moving_.emplace_back(base_ + i, std::exchange(l, PriceLevel{}));
+    set_bit(static_cast<size_t>(i), false);
+  }
+  window_count_ = 0;
+  base_ = mid - static_cast<Price>(window_ / 2);
+  for (auto& [px, l] : moving_) {
+    if (!in_window(px)) { far_.emplace(px, std::move(l)); continue; }
+    size_t i = static_cast<size_t>(px - base_);
+    window_levels_[i] = std::move(l);
+    set_bit(i, true);
+    ++window_count_;
+  }
+  auto lo = far_.lower_bound(base_);
+  auto hi = far_.lower_bound(base_ + static_cast<Price>(window_));
+  for (auto it = lo; it != hi; ++it) {
+    size_t i = static_cast<size_t>(it->first - base_);
+    window_levels_[i] = std::move(it->second);
+    set_bit(i, true);
+    ++window_count_;
+  }
+  far_.erase(lo, hi);
+}
+
+} // namespace ts
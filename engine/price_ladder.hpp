@@ -0,0 +1,146 @@
+#pragma once
+#include "common/types.hpp"
+#include "engine/pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace ts {
+
+// A resting order plus its links in the FIFO of its price level and in
+// the list of its client's resting orders (for mass cancel).
+struct OrderNode : Order {
+  OrderNode* prev{nullptr};
+  OrderNode* next{nullptr};
+  OrderNode* client_prev{nullptr};
+  OrderNode* client_next{nullptr};
+};
+
+// Intrusive doubly linked FIFO of resting orders at one price, so push,
+// pop and unlinking an arbitrary order (cancel) are all O(1). The level
+// does not own its nodes; MatchingEngine allocates and frees them.
+// total_qty/orders are kept current on add, fill and unlink; partial fills
+// of the front order must be subtracted from total_qty by the caller.
+struct PriceLevel {
+  OrderNode* head{nullptr};
+  OrderNode* tail{nullptr};
+  int64_t total_qty{0};
+  uint32_t orders{0};
+
+  bool empty() const { return head == nullptr; }
+  Order& front() { return *head; }
+  const Order& front() const { return *head; }
+  void push_back(OrderNode* n);
+  void unlink(OrderNode* n);
+  OrderNode* pop_front() { OrderNode* n = head; unlink(n); return n; }
+};
+
+// One side of the book.
+// Levels within 'window' ticks of the current price live in a contiguous
+// array indexed by (px - base_), with a one-bit-per-level occupancy map so
+// the best-price cursor can skip empty levels 64 at a time. Levels outside
+// the window fall back to a sparse std::map whose nodes are recycled
+// through a free list. Whenever the window holds no levels it is
+// re-centred on the new best price; when the best stays outside a window
+// that still holds levels (a stale order at the old price), it follows
+// too, once the map-resident best has cost about what the move does.
+class PriceLadder {
+public:
+  PriceLadder(Side side, size_t window);
+
+  bool empty() const { return levels_ == 0; }
+  size_t levels() const { return levels_; }
+  // levels kept in the sparse map, and whether the best is not among them
+  size_t far_levels() const { return far_.size(); }
+  bool best_in_window() const { return levels_ != 0 && in_window(best_); }
+
+  // best price and its queue; only valid when !empty()
+  Price best_px() const { return best_; }
+  PriceLevel& best_level() { return *slot(best_); }
+  const PriceLevel& best_level() const { return *slot(best_); }
+
+  // true if 'a' is a better price than 'b' on this side
+  bool better(Price a, Price b) const { return side_ == Side::Buy ? a > b : a < b; }
+
+  // append to the FIFO at n->px (creating the level if needed)
+  void push_back(OrderNode* n);
+
+  // drop the best level once its last order has been consumed
+  void pop_best() { release(best_); }
+
+  // unlink a resting order from its level (O(1) inside the window)
+  void remove(OrderNode* n);
+
+  // take by (< n->qty) off a resting order, keeping its place in the queue
+  void reduce(OrderNode* n, int by) {
+    n->qty -= by;
+    slot(n->px)->total_qty -= by;
+  }
+
+  // the non-empty level at px, or nullptr
+  const PriceLevel* find(Price px) const {
+    const PriceLevel* l = slot(px);
+    return l && !l->empty() ? l : nullptr;
+  }
+
+  // call f(px, level) for up to n non-empty levels, best first; f may
+  // return false to stop early
+  template <class F>
+  void visit(size_t n, F&& f) const;
+
+private:
+  Side side_;
+  size_t window_;
+  Price base_{0};                       // price of window_levels_[0]
+  std::vector<PriceLevel> window_levels_;
+  std::vector<uint64_t> occupied_;      // one bit per window level
+  size_t window_count_{0};              // non-empty levels inside the window
+  NodeFreeList far_nodes_;              // recycled far_ nodes (declared first: outlives far_)
+  std::map<Price, PriceLevel, std::less<Price>, NodeAllocator<std::pair<const Price, PriceLevel>>>
+      far_;                             // sparse levels outside the window
+  std::vector<std::pair<Price, PriceLevel>> moving_;  // recenter scratch, kept for its capacity
+  size_t levels_{0};                    // non-empty levels overall
+  size_t far_best_{0};                  // book changes since the best left the window
+  Price best_{0};
+
+  bool in_window(Price px) const { return px >= base_ && px < base_ + static_cast<Price>(window_); }
+  PriceLevel* slot(Price px);
+  const PriceLevel* slot(Price px) const;
+  void set_bit(size_t i, bool on);
+  long scan_down(size_t from) const;    // highest occupied index <= from, or -1
+  long scan_up(size_t from) const;      // lowest occupied index >= from, or -1
+  void release(Price px);               // level at px just became empty
+  Price next_best() const;
+  void track_best();
+  void recenter(Price mid);
+};
+
+template <class F>
+void PriceLadder::visit(size_t n, F&& f) const {
+  size_t seen = 0;
+  auto emit = [&](Price px, const PriceLevel& lvl) { return f(px, lvl) && ++seen < n; };
+  if (n == 0 || levels_ == 0) return;
+  const Price top = base_ + static_cast<Price>(window_);
+
+  if (side_ == Side::Buy) {
+    // sparse levels above the window, then the window, then those below it
+    for (auto it = far_.rbegin(); it != far_.rend() && it->first >= top; ++it)
+      if (!emit(it->first, it->second)) return;
+    for (long i = window_count_ ? scan_down(window_ - 1) : -1; i >= 0; i = i ? scan_down(static_cast<size_t>(i) - 1) : -1)
+      if (!emit(base_ + i, window_levels_[static_cast<size_t>(i)])) return;
+    for (auto it = std::make_reverse_iterator(far_.lower_bound(base_)); it != far_.rend(); ++it)
+      if (!emit(it->first, it->second)) return;
+  } else {
+    auto below = far_.lower_bound(base_);
+    for (auto it = far_.begin(); it != below; ++it)
+      if (!emit(it->first, it->second)) return;
+    for (long i = window_count_ ? scan_up(0) : -1; i >= 0; i = (static_cast<size_t>(i) + 1 < window_) ? scan_up(static_cast<size_t>(i) + 1) : -1)
+      if (!emit(base_ + i, window_levels_[static_cast<size_t>(i)])) return;
+    for (auto it = far_.lower_bound(top); it != far_.end(); ++it)
+      if (!emit(it->first, it->second)) return;
+  }
+}
+
+} // namespace ts
@@ -0,0 +1,71 @@
+#include "net/bar_series.hpp"
+#include <algorithm>
+
+namespace ts {
+
+BarSeries::BarSeries(uint64_t interval_ns, size_t capacity)
+    : interval_ns_(interval_ns ? interval_ns : 1), ring_(capacity ? capacity : 1) {}
+
+Bar& BarSeries::current(uint64_t ts_ns) {
+  uint64_t start = ts_ns - ts_ns % interval_ns_;
+  if (seq_ != 0) {
+    Bar& cur = ring_[seq_ % ring_.size()];
+    if (start <= cur.start_ns) return cur;  // same bucket (or the clock stepped back)
+  }
+  Bar next;
+  if (seq_ != 0) {
+    const Bar& prev = ring_[seq_ % ring_.size()];
+    next.open = next.high = next.low = next.close = prev.close;
+    next.bid = prev.bid;
+    next.ask = prev.ask;
+  }
+  next.seq = ++seq_;
+  next.start_ns = start;
+  Bar& slot = ring_[seq_ % ring_.size()];
+  slot = next;
+  return slot;
+}
+
+void BarSeries::on_trade(uint64_t ts_ns, Price px, int qty) {
+  Bar& b = current(ts_ns);
+  if (b.trades == 0) {
+    b.open = b.high = b.low = px;
+  } else {
+    b.high = std::max(b.high, px);
+    b.low = std::min(b.low, px);
+  }
+  b.close = px;
+  b.volume += static_cast<uint64_t>(qty);
+  b.notional += px * qty;
+  ++b.trades;
+}
+
+void BarSeries::on_quote(uint64_t ts_ns, const TopOfBook& top) {
+  Bar& b = current(ts_ns);
+  b.bid = top.has_bid ? top.bid_px : 0;
+  b.ask = top.has_ask ? top.ask_px : 0;
+  if (top.has_bid && top.has_ask) {
+    b.spread_sum += top.ask_px - top.bid_px;
+    ++b.quotes;
+  }
+}
+
+void BarSeries::read(uint64_t since, size_t limit, std::vector<Bar>& out) const {
+  if (seq_ == 0 || since >= seq_) return;
+  uint64_t oldest = seq_ >= ring_.size() ? seq_ - ring_.size() + 1 : 1;
+  for (uint64_t seq = std::max(since + 1, oldest); seq <= seq_ && limit > 0; ++seq, --limit)
+    out.push_back(ring_[seq % ring_.size()]);
+}
+
+void BarSet::configure(const std::vector<uint32_t>& seconds, size_t capacity) {
+  series_.clear();
+  for (uint32_t s : seconds) series_.emplace_back(uint64_t{s} * 1000000000ull, capacity);
+}
+
+const BarSeries* BarSet::find(uint32_t seconds) const {
+  for (const auto& s : series_)
+    if (s.interval_ns() == uint64_t{seconds} * 1000000000ull) return &s;
+  return nullptr;
+}
+
+} // namespace ts
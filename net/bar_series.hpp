@@ -0,0 +1,73 @@
+#pragma once
+#include "common/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts {
+
+// One time bucket of a symbol's activity. Prices are ticks.
+struct Bar {
+  uint64_t seq{0};       // per series, from 1
+  uint64_t start_ns{0};  // Unix time (wall_ns), a multiple of the interval
+  // trade prices; a bar without trades repeats the previous close (0: no trade yet)
+  Price open{0}, high{0}, low{0}, close{0};
+  uint64_t volume{0};
+  uint64_t trades{0};
+  int64_t notional{0};   // sum of px * qty; VWAP = notional / volume
+  // top of book as last seen in the bucket (0: side empty)
+  Price bid{0}, ask{0};
+  int64_t spread_sum{0};  // over the book changes with both sides quoted
+  uint64_t quotes{0};
+};
+
+// Rolling bars at one interval in a fixed ring: the newest `capacity` bars,
+// the last of them still open. Fed by the symbol's matching thread, O(1)
+// per event; buckets with no event at all are skipped, not stored.
+class BarSeries {
+public:
+  BarSeries(uint64_t interval_ns, size_t capacity);
+
+  uint64_t interval_ns() const { return interval_ns_; }
+  uint64_t last_closed() const { return seq_ ? seq_ - 1 : 0; }
+  void clear() { seq_ = 0; }
+
+  void on_trade(uint64_t ts_ns, Price px, int qty);
+  void on_quote(uint64_t ts_ns, const TopOfBook& top);
+
+  // bars with seq > since, oldest first, at most limit, the open bar last
+  void read(uint64_t since, size_t limit, std::vector<Bar>& out) const;
+
+private:
+  uint64_t interval_ns_;
+  std::vector<Bar> ring_;
+  uint64_t seq_{0};  // the open bar; 0 before the first event
+
+  Bar& current(uint64_t ts_ns);  // rolls to a new bar when ts_ns starts a later bucket
+};
+
+// Every configured interval of one symbol.
+class BarSet {
+public:
+  // intervals in seconds; replaces any series (and their bars)
+  void configure(const std::vector<uint32_t>& seconds, size_t capacity);
+
+  void on_trade(uint64_t ts_ns, Price px, int qty) {
+    for (auto& s : series_) s.on_trade(ts_ns, px, qty);
+  }
+  void on_quote(uint64_t ts_ns, const TopOfBook& top) {
+    for (auto& s : series_) s.on_quote(ts_ns, top);
+  }
+
+  void clear() {
+    for (auto& s : series_) s.clear();
+  }
+
+  const BarSeries* find(uint32_t seconds) const;
+  const std::vector<BarSeries>& series() const { return series_; }
+
+private:
+  std::vector<BarSeries> series_;
+};
+
+} // namespace ts
@@ -0,0 +1,53 @@
+#include "net/book_mirror.hpp"
+#include <sstream>
+
+namespace ts {
+
+bool BookMirror::apply(const std::string& line) {
+  std::istringstream iss(line);
+  std::string tag, kind, sym;
+  iss >> tag >> kind >> sym;
+  if (kind != "BOOK") return false;
+
+  if (tag == "SUBSCRIBED") {  // SUBSCRIBED BOOK <sym> SEQ <n> LEVELS <k>
+    std::string seq_tag;
+    uint64_t seq = 0;
+    if (!(iss >> seq_tag >> seq)) return false;
+    bids_.clear();
+    asks_.clear();
+    seq_ = seq;
+    ready_ = true;
+    return true;
+  }
+  if (tag != "MD") return false;
+
+  // MD BOOK <sym> <seq> <BID|ASK> <px> <qty> <orders>
+  uint64_t seq = 0;
+  std::string side;
+  double px = 0;
+  int64_t qty = 0;
+  if (!(iss >> seq >> side >> px >> qty)) return false;
+  seq_ = seq;
+  if (side == "BID") {
+    if (qty > 0) bids_[px] = qty; else bids_.erase(px);
+  } else {
+    if (qty > 0) asks_[px] = qty; else asks_.erase(px);
+  }
+  return true;
+}
+
+bool BookMirror::best_bid(double& px, int64_t& qty) const {
+  if (bids_.empty()) return false;
+  px = bids_.begin()->first;
+  qty = bids_.begin()->second;
+  return true;
+}
+
+bool BookMirror::best_ask(double& px, int64_t& qty) const {
+  if (asks_.empty()) return false;
+  px = asks_.begin()->first;
+  qty = asks_.begin()->second;
+  return true;
+}
+
+} // namespace ts
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace ts {
+
+// Client-side copy of one symbol's book, kept current from the server's
+// SUBSCRIBE BOOK feed (the SUBSCRIBED snapshot plus MD BOOK updates).
+class BookMirror {
+public:
+  // Applies a feed line; false if the line is not book data.
+  bool apply(const std::string& line);
+
+  bool ready() const { return ready_; }  // snapshot seen
+  uint64_t seq() const { return seq_; }
+
+  bool best_bid(double& px, int64_t& qty) const;
+  bool best_ask(double& px, int64_t& qty) const;
+
+private:
+  bool ready_{false};
+  uint64_t seq_{0};
+  std::map<double, int64_t, std::greater<double>> bids_;
+  std::map<double, int64_t> asks_;
+};
+
+} // namespace ts
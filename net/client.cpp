@@ -1,8 +1,13 @@
 #include "net/client.hpp"
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
 
 namespace ts {
@@ -10,6 +15,14 @@ namespace ts {
 Client::Client() {}
 Client::~Client() { close(); }
 
+// orders are small single lines: send each at once rather than waiting for
+// the previous one's ACK (the server does the same for its replies)
+static int set_nodelay(int fd) {
+  int one = 1;
+  (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
 bool Client::connect(const std::string& host, int port) {
   close();
 
@@ -28,11 +41,11 @@ bool Client::connect(const std::string& host, int port) {
     if (p->ai_family == AF_INET) {
       sockaddr_in a = *reinterpret_cast<sockaddr_in*>(p->ai_addr);
       a.sin_port = htons((uint16_t)port);
-      if (::connect(fd, (sockaddr*)&a, sizeof(a)) == 0) { freeaddrinfo(res); fd_ = fd; return true; }
+      if (::connect(fd, (sockaddr*)&a, sizeof(a)) == 0) { freeaddrinfo(res); fd_ = set_nodelay(fd); return true; }
     } else {
       sockaddr_in6 a6 = *reinterpret_cast<sockaddr_in6*>(p->ai_addr);
       a6.sin6_port = htons((uint16_t)port);
-      if (::connect(fd, (sockaddr*)&a6, sizeof(a6)) == 0) { freeaddrinfo(res); fd_ = fd; return true; }
+      if (::connect(fd, (sockaddr*)&a6, sizeof(a6)) == 0) { freeaddrinfo(res); fd_ = set_nodelay(fd); return true; }
     }
     ::close(fd);
   }
@@ -53,22 +66,54 @@ bool Client::send_line(const std::string& s) {
   return true;
 }
 
+bool Client::take_line(std::string& out) {
+  size_t nl = rbuf_.find('\n', rpos_);
+  if (nl == std::string::npos) return false;
+  size_t end = (nl > rpos_ && rbuf_[nl - 1] == '\r') ? nl - 1 : nl;
+  out.assign(rbuf_, rpos_, end - rpos_);
+  rpos_ = nl + 1;
+  if (rpos_ == rbuf_.size()) { rbuf_.clear(); rpos_ = 0; }
+  return true;
+}
+
+int Client::fill() {
+  if (rbuf_.size() - rpos_ > 4096) return -1;
+  if (rpos_ > 0) { rbuf_.erase(0, rpos_); rpos_ = 0; }
+
+  char chunk[4096];
+  ssize_t r = ::recv(fd_, chunk, sizeof(chunk), 0);
+  if (r <= 0) return -1;
+  rbuf_.append(chunk, (size_t)r);
+  return 1;
+}
+
 bool Client::read_line(std::string& out) {
   if (fd_ < 0) return false;
-  out.clear();
-  char ch;
-  while (true) {
-    ssize_t r = ::recv(fd_, &ch, 1, 0);
-    if (r <= 0) return false;
-    if (ch == '\n') break;
-    if (ch != '\r') out.push_back(ch);
-    if (out.size() > 4096) return false;
+  while (!take_line(out)) {
+    if (fill() < 0) return false;
   }
   return true;
 }
 
+int Client::try_read_line(std::string& out, int timeout_ms) {
+  if (fd_ < 0) return -1;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!take_line(out)) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now()).count();
+    pollfd p{fd_, POLLIN, 0};
+    int n = ::poll(&p, 1, left > 0 ? (int)left : 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return n == 0 ? 0 : -1;
+    if (fill() < 0) return -1;
+  }
+  return 1;
+}
+
 void Client::close() {
   if (fd_ >= 0) { ::shutdown(fd_, SHUT_RDWR); ::close(fd_); fd_ = -1; }
+  rbuf_.clear();
+  rpos_ = 0;
 }
 
 } // namespace ts
@@ -14,14 +14,27 @@ public:
   // Send one line (adds newline)
   bool send_line(const std::string& s);
 
-  // Read one line (strips \r\n); false on disconnect/error
+  // Read one line (strips \r\n); false on disconnect/error.
+  // Reads in chunks, so pipelined replies cost one recv for many lines.
   bool read_line(std::string& out);
 
+  // Like read_line, but waits at most timeout_ms (0 = only what is buffered
+  // or already on the socket). 1 = line read, 0 = timed out, -1 = closed.
+  int try_read_line(std::string& out, int timeout_ms);
+
   // Close socket
   void close();
 
+  // socket for poll()ing many clients from one thread; -1 when closed
+  int fd() const { return fd_; }
+
 private:
   int fd_{-1};
+  std::string rbuf_;   // received bytes not yet returned by read_line
+  size_t rpos_{0};
+
+  bool take_line(std::string& out);  // next complete line from rbuf_
+  int fill();                         // one recv into rbuf_: >0 ok, 0/-1 closed
 };
 
 } // namespace ts
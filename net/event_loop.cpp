@@ -0,0 +1,338 @@
+#include "net/event_loop.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace ts {
+
+void Connection::send(std::string_view line) {
+  if (issued_ == written_) {  // nothing owed: straight to the socket buffer
+    ++issued_;
+    ++written_;
+    out_.append(line.data(), line.size());
+    out_ += '\n';
+    return;
+  }
+  complete(issued_++, std::string(line));
+}
+
+Connection::~Connection() {
+  for (Mail* m = mail_.exchange(nullptr, std::memory_order_acquire); m;) {
+    Mail* next = m->next;
+    delete m;
+    m = next;
+  }
+}
+
+void Connection::deliver(uint64_t slot, std::string reply) {
+  Mail* m = new Mail{slot, std::move(reply), nullptr};
+  Mail* head = mail_.load(std::memory_order_relaxed);
+  do {
+    m->next = head;  // m belongs to the loop once the exchange succeeds
+  } while (!mail_.compare_exchange_weak(head, m, std::memory_order_release, std::memory_order_relaxed));
+  // one wake-up per batch of mail; the loop empties mail_ when it collects
+  if (head == nullptr) loop_->notify(self_.lock());
+}
+
+void Connection::complete(uint64_t slot, std::string&& reply) {
+  if (slot != written_) {
+    held_.emplace(slot, std::move(reply));
+    return;
+  }
+  out_ += reply;
+  out_ += '\n';
+  ++written_;
+  // release anything that was waiting on this slot
+  for (auto it = held_.begin(); it != held_.end() && it->first == written_; it = held_.erase(it)) {
+    out_ += it->second;
+    out_ += '\n';
+    ++written_;
+  }
+}
+
+EventLoop::EventLoop(OpenHandler on_open, LineHandler on_line)
+    : on_open_(std::move(on_open)), on_line_(std::move(on_line)), read_buf_(kReadChunk) {}
+
+EventLoop::~EventLoop() { stop(); }
+
+static bool set_nonblocking(int fd) {
+  int fl = ::fcntl(fd, F_GETFL, 0);
+  return fl >= 0 && ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+bool EventLoop::start() {
+#ifdef __linux__
+  poll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+#else
+  poll_fd_ = ::kqueue();
+#endif
+  if (poll_fd_ < 0) { perror("event loop"); return false; }
+  int p[2];
+  if (::pipe(p) != 0) { perror("pipe"); return false; }
+  wake_rd_ = p[0];
+  wake_wr_ = p[1];
+  set_nonblocking(wake_rd_);
+  set_nonblocking(wake_wr_);
+  if (!watch(wake_rd_)) return false;
+
+  running_.store(true);
+  thread_ = std::thread([this] { loop(); });
+  return true;
+}
+
+void EventLoop::stop() {
+  if (!running_.exchange(false)) return;
+  wake();
+  if (thread_.joinable()) thread_.join();
+  for (auto& kv : conns_) ::close(kv.first);
+  conns_.clear();
+  if (wake_rd_ >= 0) { ::close(wake_rd_); wake_rd_ = -1; }
+  if (wake_wr_ >= 0) { ::close(wake_wr_); wake_wr_ = -1; }
+  if (poll_fd_ >= 0) { ::close(poll_fd_); poll_fd_ = -1; }
+}
+
+bool EventLoop::watch(int fd) {
+#ifdef __linux__
+  epoll_event ev{};
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.fd = fd;
+  return ::epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+#else
+  struct kevent ch[2];
+  EV_SET(&ch[0], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+  EV_SET(&ch[1], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+  return ::kevent(poll_fd_, ch, 2, nullptr, 0, nullptr) == 0;
+#endif
+}
+
+void EventLoop::adopt(int fd) {
+  bool need_wake;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    adopted_.push_back(fd);
+    need_wake = !wake_pending_;
+    wake_pending_ = true;
+  }
+  if (need_wake) wake();
+}
+
+void EventLoop::notify(std::shared_ptr<Connection> conn) {
+  if (!conn) return;
+  bool need_wake;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    notified_.push_back(std::move(conn));
+    need_wake = !wake_pending_;
+    wake_pending_ = true;
+  }
+  if (need_wake) wake();
+}
+
+void EventLoop::post(std::function<void()> task) {
+  bool need_wake;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    tasks_.push_back(std::move(task));
+    need_wake = !wake_pending_;
+    wake_pending_ = true;
+  }
+  if (need_wake) wake();
+}
+
+void EventLoop::wake() {
+  char b = 1;
+  (void)!::write(wake_wr_, &b, 1);
+}
+
+void EventLoop::loop() {
+  constexpr int kMaxEvents = 256;
+#ifdef __linux__
+  epoll_event evs[kMaxEvents];
+#else
+  struct kevent evs[kMaxEvents];
+#endif
+
+  while (running_.load(std::memory_order_relaxed)) {
+#ifdef __linux__
+    int n = ::epoll_wait(poll_fd_, evs, kMaxEvents, -1);
+#else
+    int n = ::kevent(poll_fd_, nullptr, 0, evs, kMaxEvents, nullptr);
+#endif
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("event wait");
+      break;
+    }
+    for (int i = 0; i < n; ++i) {
+#ifdef __linux__
+      int fd = evs[i].data.fd;
+      bool readable = evs[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+      bool writable = evs[i].events & EPOLLOUT;
+      bool hup = evs[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+#else
+      int fd = static_cast<int>(evs[i].ident);
+      bool readable = evs[i].filter == EVFILT_READ;
+      bool writable = evs[i].filter == EVFILT_WRITE;
+      bool hup = evs[i].flags & (EV_EOF | EV_ERROR);
+#endif
+      if (fd == wake_rd_) {
+        // wake_pending_ keeps this to a byte or two, so one read empties it
+        char buf[256];
+        (void)!::read(wake_rd_, buf, sizeof(buf));
+        drain_inbox();
+        continue;
+      }
+      auto it = conns_.find(fd);
+      if (it == conns_.end()) continue;
+      std::shared_ptr<Connection> c = it->second;
+      if (readable) on_readable(c, hup);
+      if (writable && !c->closed_) {
+        flush(c);
+        // room in out_ may let stalled input be parsed (and paused reads resume)
+        if (!c->closed_ && (c->read_paused_ || c->in_pos_ < c->in_.size())) on_readable(c, false);
+      }
+    }
+  }
+}
+
+void EventLoop::drain_inbox() {
+  std::vector<int> adopted;
+  std::vector<std::shared_ptr<Connection>> notified;
+  std::vector<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    adopted.swap(adopted_);
+    notified.swap(notified_);
+    tasks.swap(tasks_);
+    wake_pending_ = false;
+  }
+  for (int fd : adopted) open_conn(fd);
+  for (auto& c : notified) {
+    if (c->closed_) continue;
+    collect_mail(c);
+    if (c->read_paused_) { on_readable(c, false); continue; }  // replies made room: read on
+    parse_lines(c);
+    flush(c);
+  }
+  for (auto& t : tasks) t();
+}
+
+void EventLoop::open_conn(int fd) {
+  set_nonblocking(fd);
+  auto c = std::make_shared<Connection>(fd, this);
+  c->self_ = c;
+  conns_[fd] = c;
+  open_.fetch_add(1, std::memory_order_relaxed);
+  if (!watch(fd)) { close_conn(c); return; }
+  on_open_(c);
+  flush(c);
+}
+
+void EventLoop::on_readable(const std::shared_ptr<Connection>& c, bool peer_closed) {
+  // edge-triggered: drain the socket. A short read means it is empty unless
+  // the peer also hung up, in which case keep going until recv() sees EOF.
+  // Past kMaxInput unparsed bytes reading stops; it resumes from here once
+  // parsing made room (no new edge is needed: the loop calls back).
+  c->hup_ = c->hup_ || peer_closed;
+  while (true) {
+    c->read_paused_ = false;
+    while (!c->eof_) {
+      if (c->in_.size() - c->in_pos_ >= kMaxInput) { c->read_paused_ = true; break; }
+      ssize_t r = ::recv(c->fd_, read_buf_.data(), read_buf_.size(), 0);
+      if (r > 0) {
+        c->in_.append(read_buf_.data(), static_cast<size_t>(r));
+        if (static_cast<size_t>(r) < read_buf_.size() && !c->hup_) break;
+        continue;
+      }
+      if (r == 0) { c->eof_ = true; break; }
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      close_conn(c);
+      return;
+    }
+    size_t before = c->in_.size() - c->in_pos_;
+    parse_lines(c);
+    if (c->closed_) return;
+    // full buffer and parsing made room: read more now; otherwise the
+    // owed replies or a new edge bring us back
+    if (!c->read_paused_ || c->in_.size() - c->in_pos_ >= before) break;
+  }
+  flush(c);
+}
+
+void EventLoop::collect_mail(const std::shared_ptr<Connection>& c) {
+  // the stack is newest first; complete oldest first so slots rarely wait
+  mail_scratch_.clear();
+  for (Connection::Mail* m = c->mail_.exchange(nullptr, std::memory_order_acquire); m; m = m->next)
+    mail_scratch_.push_back(m);
+  for (auto it = mail_scratch_.rbegin(); it != mail_scratch_.rend(); ++it) {
+    c->complete((*it)->slot, std::move((*it)->reply));
+    delete *it;
+  }
+}
+
+void EventLoop::parse_lines(const std::shared_ptr<Connection>& c) {
+  // frame every complete line already buffered; the handler sees views into in_
+  // partial_only: what is left holds no newline (known only if the scan got there)
+  bool partial_only = false;
+  while (!c->closing && !c->closed_ && c->pending() < kMaxInFlight &&
+         c->out_.size() < kMaxOutput) {
+    const char* base = c->in_.data() + c->in_pos_;
+    size_t avail = c->in_.size() - c->in_pos_;
+    const void* nl = std::memchr(base, '\n', avail);
+    if (!nl) { partial_only = true; break; }
+    size_t len = static_cast<size_t>(static_cast<const char*>(nl) - base);
+    c->in_pos_ += len + 1;
+    if (len > 0 && base[len - 1] == '\r') --len;
+    lines_.store(lines_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    on_line_(c, std::string_view(base, len));
+  }
+  if (c->closed_) return;
+
+  // drop consumed bytes
+  if (c->in_pos_ == c->in_.size()) { c->in_.clear(); c->in_pos_ = 0; }
+  else if (c->in_pos_ >= kReadChunk) { c->in_.erase(0, c->in_pos_); c->in_pos_ = 0; }
+
+  size_t unparsed = c->in_.size() - c->in_pos_;
+  if (partial_only && unparsed > kMaxLine) { close_conn(c); return; }
+  // peer finished sending and everything it sent has been answered
+  if (c->eof_ && partial_only && c->pending() == 0) c->closing = true;
+}
+
+void EventLoop::flush(const std::shared_ptr<Connection>& c) {
+  size_t off = 0;
+  while (off < c->out_.size()) {
+    ssize_t w = ::send(c->fd_, c->out_.data() + off, c->out_.size() - off, 0);
+    if (w > 0) { off += static_cast<size_t>(w); continue; }
+    if (w < 0 && errno == EINTR) continue;
+    if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    close_conn(c);
+    return;
+  }
+  c->out_.erase(0, off);
+  if (c->out_.empty() && c->want_drain && on_drain_) {
+    c->want_drain = false;
+    on_drain_(c);  // may queue more output
+    if (!c->out_.empty()) { flush(c); return; }
+  }
+  if (c->closing && c->pending() == 0 && c->out_.empty()) close_conn(c);
+}
+
+void EventLoop::close_conn(const std::shared_ptr<Connection>& c) {
+  if (c->closed_) return;
+  c->closed_ = true;
+  ::close(c->fd_);  // also removes it from the epoll/kqueue set
+  conns_.erase(c->fd_);
+  open_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+} // namespace ts
@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ts {
+
+class EventLoop;
+
+// Protocol state a line handler keeps on a connection between lines.
+struct ConnectionState {
+  virtual ~ConnectionState() = default;
+};
+
+// One client session. The socket and both buffers belong to the owning
+// EventLoop's thread; other threads (matching shards) only hand replies in
+// through deliver().
+//
+// Every reply owns a slot number. Commands handed to a matching thread
+// reserve one and may finish out of order across shards; replies are still
+// written in slot order, so a pipelining client sees them as it sent them.
+class Connection {
+public:
+  Connection(int fd, EventLoop* loop) : fd_(fd), loop_(loop) {}
+  ~Connection();
+
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  int fd() const { return fd_; }
+  EventLoop* loop() const { return loop_; }
+
+  // loop thread: queue a reply line (newline added) behind any owed replies
+  void send(std::string_view line);
+  // loop thread: reserve the reply slot for a command answered elsewhere
+  uint64_t reserve() { return issued_++; }
+  // loop thread: replies reserved but not yet written to out_
+  size_t pending() const { return static_cast<size_t>(issued_ - written_); }
+
+  // loop thread: close once the output buffer has drained
+  bool closing{false};
+  // loop thread: call the loop's drain handler once out_ empties
+  bool want_drain{false};
+  // loop thread: the line handler's state for this session, if any
+  std::unique_ptr<ConnectionState> state;
+
+  // loop thread: bytes queued for the socket
+  size_t backlog() const { return out_.size(); }
+  bool closed() const { return closed_; }
+
+  // any thread: fill a reserved slot and wake the loop (lock-free)
+  void deliver(uint64_t slot, std::string reply);
+
+private:
+  friend class EventLoop;
+
+  int fd_;
+  EventLoop* loop_;
+  std::weak_ptr<Connection> self_;
+  std::string in_;        // bytes received, not yet framed
+  size_t in_pos_{0};      // start of the first unparsed line in in_
+  std::string out_;       // bytes not yet accepted by the socket
+  bool eof_{false};       // peer shut down its sending side
+  bool hup_{false};       // peer hung up; read on to EOF when reading resumes
+  bool read_paused_{false};  // in_ is full: socket left unread (TCP backpressure)
+  bool closed_{false};
+
+  uint64_t issued_{0};    // next slot to hand out
+  uint64_t written_{0};   // next slot to append to out_
+  std::map<uint64_t, std::string> held_;  // finished ahead of an earlier slot
+
+  // Replies from the matching threads: a lock-free stack (push = one CAS).
+  // Order does not matter since slots put replies back in sequence; the
+  // push that finds it empty wakes the loop, which takes the whole stack.
+  struct Mail {
+    uint64_t slot;
+    std::string reply;
+    Mail* next;
+  };
+  std::atomic<Mail*> mail_{nullptr};
+
+  void complete(uint64_t slot, std::string&& reply);
+};
+
+// Edge-triggered readiness loop (epoll on Linux, kqueue elsewhere) serving
+// many non-blocking connections from a single thread.
+class EventLoop {
+public:
+  using OpenHandler = std::function<void(const std::shared_ptr<Connection>&)>;
+  // line is a view into the receive buffer, valid only during the call
+  using LineHandler = std::function<void(const std::shared_ptr<Connection>&, std::string_view line)>;
+  using DrainHandler = std::function<void(const std::shared_ptr<Connection>&)>;
+
+  EventLoop(OpenHandler on_open, LineHandler on_line);
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  bool start();
+  void stop();
+
+  // any thread: take ownership of an accepted, non-blocking socket
+  void adopt(int fd);
+  // any thread: conn has mail waiting
+  void notify(std::shared_ptr<Connection> conn);
+  // any thread: run task on the loop thread
+  void post(std::function<void()> task);
+  // loop thread: write whatever a task queued on conn
+  void flush_now(const std::shared_ptr<Connection>& conn) {
+    if (!conn->closed_) flush(conn);
+  }
+  // before start(): called for connections with want_drain set once their
+  // output buffer has been fully written
+  void set_drain_handler(DrainHandler h) { on_drain_ = std::move(h); }
+
+  size_t connections() const { return open_.load(std::memory_order_relaxed); }
+  uint64_t lines() const { return lines_.load(std::memory_order_relaxed); }  // commands framed
+
+private:
+  static constexpr size_t kReadChunk = 64 * 1024;
+  static constexpr size_t kMaxLine = 4096;         // longer lines drop the client
+  static constexpr size_t kMaxOutput = 4 << 20;    // stop parsing input past this backlog
+  static constexpr size_t kMaxInFlight = 256;      // ...or past this many owed replies
+  // unparsed input kept per connection: past it the socket is not read
+  // until parsing catches up, so a client that never reads its replies
+  // is held back by TCP instead of growing in_
+  static constexpr size_t kMaxInput = kMaxLine * kMaxInFlight;
+
+  OpenHandler on_open_;
+  LineHandler on_line_;
+  DrainHandler on_drain_;
+  int poll_fd_{-1};
+  int wake_rd_{-1};
+  int wake_wr_{-1};
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<size_t> open_{0};
+  std::atomic<uint64_t> lines_{0};  // written by the loop thread only
+  std::unordered_map<int, std::shared_ptr<Connection>> conns_;
+  std::vector<char> read_buf_;
+  std::vector<Connection::Mail*> mail_scratch_;
+
+  std::mutex mu_;  // guards the inbox below
+  std::vector<int> adopted_;
+  std::vector<std::shared_ptr<Connection>> notified_;
+  std::vector<std::function<void()>> tasks_;
+  bool wake_pending_{false};
+
+  void loop();
+  void wake();
+  void drain_inbox();
+  void open_conn(int fd);
+  void on_readable(const std::shared_ptr<Connection>& c, bool peer_closed);
+  void collect_mail(const std::shared_ptr<Connection>& c);
+  void parse_lines(const std::shared_ptr<Connection>& c);
+  void flush(const std::shared_ptr<Connection>& c);
+  void close_conn(const std::shared_ptr<Connection>& c);
+  bool watch(int fd);
+};
+
+} // namespace ts
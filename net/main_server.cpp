@@ -1,8 +1,121 @@
 #include "net/server.hpp"
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
-int main() {
-  ts::Server s(5555);
+// "AUM,XYZ:0.05" -> {AUM tick 0.01, XYZ tick 0.05}
+static std::vector<ts::SymbolSpec> parse_symbols(const std::string& s) {
+  std::vector<ts::SymbolSpec> out;
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    if (item.empty()) continue;
+    ts::SymbolSpec spec;
+    auto colon = item.find(':');
+    spec.name = item.substr(0, colon);
+    if (colon != std::string::npos) spec.tick_size = std::stod(item.substr(colon + 1));
+    out.push_back(spec);
+  }
+  return out;
+}
+
+static std::vector<int> parse_cpus(const std::string& s) {
+  std::vector<int> out;
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) if (!item.empty()) out.push_back(std::stoi(item));
+  return out;
+}
+
+static std::vector<uint32_t> parse_intervals(const std::string& s) {
+  std::vector<uint32_t> out;
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    if (item.empty()) continue;
+    unsigned long v = std::stoul(item);
+    if (v == 0 || v > 86400) throw std::invalid_argument("bar interval");
+    out.push_back(static_cast<uint32_t>(v));
+  }
+  return out;
+}
+
+static ts::Server* g_server = nullptr;
+
+// Ctrl-C / kill: stop accepting so run() returns and the logs are flushed
+static void on_signal(int) {
+  if (g_server) g_server->stop();
+}
+
+static void usage() {
+  std::cerr << "usage: tradesim_server [port] [key=value ...]\n"
+               "  port=5555            listen port\n"
+               "  symbols=AUM          comma list, optional :tick per symbol (XYZ:0.05)\n"
+               "  match_threads=1      matching threads; symbols are spread round-robin\n"
+               "  cpus=                comma list of CPUs to pin matching threads to (Linux)\n"
+               "  io_threads=1         event loops serving client sockets\n"
+               "  trade_history=65536  trades kept per symbol for TRADES\n"
+               "  order_pool=65536     resting orders preallocated per symbol (grows past it)\n"
+               "  huge_pages=0         1: back the order pools with huge pages if available\n"
+               "  state_dir=state      command journal + snapshots for crash recovery (empty: off)\n"
+               "  state_fsync=1        0: skip fdatasync per group commit (faster, not crash-safe)\n"
+               "  snapshot_every=100000  commands between snapshots\n"
+               "  metrics_port=0       plain-text (Prometheus) metrics on 127.0.0.1 (0: off)\n"
+               "  bars=1,10,60         bar intervals in seconds for BARS\n"
+               "  bar_history=1440     bars kept per interval and symbol\n"
+               "  log_ring=65536       records buffered for the CSV writer thread\n"
+               "  log_full=drop        drop|block when that buffer is full\n"
+               "  log_flush_ms=100     write CSVs at least this often (0: size/close only)\n"
+               "  log_flush_kb=64      ...or once this much text is pending\n"
+               "  log_fsync=0          1: fsync the CSVs on shutdown\n";
+}
+
+int main(int argc, char** argv) {
+  ts::ServerConfig cfg;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto eq = arg.find('=');
+      if (eq == std::string::npos && i == 1) { cfg.port = std::stoi(arg); continue; }
+      if (eq == std::string::npos) { usage(); return 1; }
+      std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+      if (key == "port") cfg.port = std::stoi(val);
+      else if (key == "symbols") cfg.symbols = parse_symbols(val);
+      else if (key == "match_threads") cfg.match_threads = std::stoul(val);
+      else if (key == "cpus") cfg.match_cpus = parse_cpus(val);
+      else if (key == "io_threads") cfg.io_threads = std::stoul(val);
+      else if (key == "trade_history") cfg.trade_history = std::stoul(val);
+      else if (key == "order_pool") cfg.pool.order_capacity = std::stoul(val);
+      else if (key == "huge_pages") cfg.pool.huge_pages = (val == "1");
+      else if (key == "state_dir") cfg.journal.dir = val;
+      else if (key == "state_fsync") cfg.journal.fsync = (val == "1");
+      else if (key == "snapshot_every") cfg.journal.snapshot_every = std::stoull(val);
+      else if (key == "metrics_port") cfg.metrics_port = std::stoi(val);
+      else if (key == "bars") cfg.bar_intervals = parse_intervals(val);
+      else if (key == "bar_history") cfg.bar_history = std::stoul(val);
+      else if (key == "log_ring") cfg.log.ring_capacity = std::stoul(val);
+      else if (key == "log_full" && (val == "drop" || val == "block")) cfg.log.block_when_full = (val == "block");
+      else if (key == "log_flush_ms") cfg.log.flush_interval_ms = static_cast<uint32_t>(std::stoul(val));
+      else if (key == "log_flush_kb") cfg.log.flush_bytes = std::stoul(val) << 10;
+      else if (key == "log_fsync") cfg.log.fsync_on_close = (val == "1");
+      else { usage(); return 1; }
+    }
+  } catch (...) {
+    usage();
+    return 1;
+  }
+  if (cfg.symbols.empty()) { usage(); return 1; }
+  if (cfg.symbols.size() > ts::kJournalMaxSymbols) {
+    std::cerr << "at most " << ts::kJournalMaxSymbols << " symbols per server\n";
+    return 1;
+  }
+
+  ts::Server s(cfg);
+  g_server = &s;
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
   s.run();
   return 0;
 }
-
@@ -0,0 +1,186 @@
+#include "net/market_feed.hpp"
+
+namespace ts {
+
+static const char* side_tag(Side s) { return s == Side::Buy ? "BID" : "ASK"; }
+
+static void append_level(std::string& out, const SymbolBook& b, uint64_t seq, const LevelChange& l) {
+  out += "MD BOOK ";
+  out += b.symbol;
+  out += ' ';
+  out += std::to_string(seq);
+  out += ' ';
+  out += side_tag(l.side);
+  out += ' ';
+  out += b.engine.scale().format(l.px);
+  out += ' ';
+  out += std::to_string(l.qty);
+  out += ' ';
+  out += std::to_string(l.orders);
+}
+
+static void append_trade(std::string& out, const SymbolBook& b, const TradeTick& t) {
+  out += "MD TRADE ";
+  out += b.symbol;
+  out += ' ';
+  out += std::to_string(t.seq);
+  out += ' ';
+  out += std::to_string(t.qty);
+  out += '@';
+  out += b.engine.scale().format(t.px);
+  out += t.taker_side == Side::Buy ? " BUY" : " SELL";
+}
+
+static void append_fill(std::string& out, const SymbolBook& b, uint64_t seq, uint64_t order_id, int qty,
+                        Price px, Side side) {
+  out += "MD FILL ";
+  out += b.symbol;
+  out += ' ';
+  out += std::to_string(seq);
+  out += ' ';
+  out += std::to_string(order_id);
+  out += ' ';
+  out += std::to_string(qty);
+  out += '@';
+  out += b.engine.scale().format(px);
+  out += side == Side::Buy ? " BUY" : " SELL";
+}
+
+void MarketFeed::add(const std::shared_ptr<Subscription>& sub) {
+  sub->book->subscribers.fetch_add(1, std::memory_order_relaxed);
+  subs_.push_back(sub);
+}
+
+void MarketFeed::drop(Subscription& s) {
+  s.book->subscribers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool MarketFeed::remove(const Connection* conn, const SymbolBook* book, FeedKind kind) {
+  for (auto it = subs_.begin(); it != subs_.end(); ++it) {
+    auto& s = **it;
+    if (s.book == book && s.kind == kind && s.conn.lock().get() == conn) {
+      drop(s);
+      subs_.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string MarketFeed::snapshot(Subscription& sub, SymbolBook& book, size_t depth) {
+  std::string out;
+  if (sub.kind != FeedKind::Book) {
+    uint64_t seq = book.trades.last_seq();
+    sub.start_seq.store(seq, std::memory_order_release);
+    return std::string(sub.kind == FeedKind::Trades ? "SUBSCRIBED TRADES " : "SUBSCRIBED FILLS ") + book.symbol +
+           " SEQ " + std::to_string(seq);
+  }
+  std::vector<DepthLevel> bids, asks;
+  book.engine.depth(depth, bids, asks);
+  uint64_t seq = book.book_seq;
+  sub.start_seq.store(seq, std::memory_order_release);
+  out = "SUBSCRIBED BOOK " + book.symbol + " SEQ " + std::to_string(seq) + " LEVELS " +
+        std::to_string(bids.size() + asks.size());
+  for (const auto& l : bids) {
+    out += '\n';
+    append_level(out, book, seq, LevelChange{Side::Buy, l.px, l.qty, l.orders});
+  }
+  for (const auto& l : asks) {
+    out += '\n';
+    append_level(out, book, seq, LevelChange{Side::Sell, l.px, l.qty, l.orders});
+  }
+  return out;
+}
+
+void MarketFeed::on_update(const MarketUpdate& u) {
+  std::string line;
+  for (size_t i = 0; i < subs_.size();) {
+    Subscription& s = *subs_[i];
+    std::shared_ptr<Connection> c = s.conn.lock();
+    if (!c || c->closed()) {  // client went away: forget it
+      drop(s);
+      subs_[i] = std::move(subs_.back());
+      subs_.pop_back();
+      continue;
+    }
+    ++i;
+    if (s.book != u.book) continue;
+    uint64_t start = s.start_seq.load(std::memory_order_acquire);
+    if (start == Subscription::kUnset) continue;  // snapshot not taken yet
+
+    if (s.kind == FeedKind::Fills) {
+      for (size_t k = 0; k < u.fills.size(); ++k) {
+        const Trade& f = u.fills[k];
+        uint64_t seq = u.fills_seq + k;
+        if (seq <= start) continue;
+        // a self-trade fills two of the client's orders: two lines
+        if (f.maker_client == s.client) {
+          line.clear();
+          append_fill(line, *u.book, seq, f.maker_id, f.qty, f.px, f.maker_side);
+          c->send(line);
+        }
+        if (f.taker_client == s.client) {
+          line.clear();
+          append_fill(line, *u.book, seq, f.taker_id, f.qty, f.px, f.taker_side);
+          c->send(line);
+        }
+      }
+      loop_.flush_now(c);
+      continue;
+    }
+
+    bool behind = c->backlog() > kConflateBytes;
+    if (!behind && (!s.dirty.empty() || s.gap_to)) emit_dirty(*c, s);  // caught up
+    if (s.kind == FeedKind::Book) {
+      if (u.book_seq > start) {
+        for (const auto& l : u.levels) {
+          if (behind) {
+            s.dirty[{static_cast<int>(l.side), l.px}] = l;
+            continue;
+          }
+          line.clear();
+          append_level(line, *u.book, u.book_seq, l);
+          c->send(line);
+        }
+        if (behind) s.dirty_seq = u.book_seq;
+      }
+    } else {
+      for (const auto& t : u.trades) {
+        if (t.seq <= start) continue;
+        if (behind) {
+          if (!s.gap_from) s.gap_from = t.seq;
+          s.gap_to = t.seq;
+          continue;
+        }
+        line.clear();
+        append_trade(line, *u.book, t);
+        c->send(line);
+      }
+    }
+    if (behind) c->want_drain = true;
+    loop_.flush_now(c);
+  }
+}
+
+void MarketFeed::on_drain(const std::shared_ptr<Connection>& conn) {
+  for (auto& sp : subs_) {
+    if (sp->conn.lock() == conn) emit_dirty(*conn, *sp);
+  }
+}
+
+void MarketFeed::emit_dirty(Connection& c, Subscription& s) {
+  std::string line;
+  for (const auto& kv : s.dirty) {
+    line.clear();
+    append_level(line, *s.book, s.dirty_seq, kv.second);
+    c.send(line);
+  }
+  s.dirty.clear();
+  if (s.gap_to) {
+    c.send("MD TRADES_GAP " + s.book->symbol + " " + std::to_string(s.gap_from) + " " +
+           std::to_string(s.gap_to));
+    s.gap_from = s.gap_to = 0;
+  }
+}
+
+} // namespace ts
@@ -0,0 +1,98 @@
+#pragma once
+#include "common/types.hpp"
+#include "net/event_loop.hpp"
+#include "net/symbol_registry.hpp"
+#include "net/trade_ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+struct LevelChange {
+  Side side;
+  Price px;
+  int64_t qty;      // 0: level removed
+  uint32_t orders;
+};
+
+// Everything one order or cancel did to a symbol, built on the matching
+// thread and shared read-only by every event loop.
+struct MarketUpdate {
+  const SymbolBook* book{nullptr};
+  uint64_t book_seq{0};
+  std::vector<LevelChange> levels;
+  std::vector<TradeTick> trades;
+  std::vector<Trade> fills;  // the same trades with both orders, for FILLS
+  uint64_t fills_seq{0};     // trade seq of fills[0]
+};
+
+enum class FeedKind { Book, Trades, Fills };
+
+struct Subscription {
+  static constexpr uint64_t kUnset = std::numeric_limits<uint64_t>::max();
+
+  Subscription(std::shared_ptr<Connection> c, SymbolBook* b, FeedKind k)
+      : conn(std::move(c)), book(b), kind(k) {}
+
+  std::weak_ptr<Connection> conn;
+  SymbolBook* book;
+  FeedKind kind;
+  ClientId client{0};  // Fills: whose orders
+  // set by the matching thread when the snapshot is taken; updates at or
+  // below it are already covered, and none are sent before it is known
+  std::atomic<uint64_t> start_seq{kUnset};
+
+  // loop thread: conflated state while the reader is behind
+  std::map<std::pair<int, Price>, LevelChange> dirty;
+  uint64_t dirty_seq{0};
+  uint64_t gap_from{0}, gap_to{0};  // trade prints skipped
+};
+
+// Per-event-loop fan-out of market data to that loop's subscribers.
+//
+// Wire format (pushed lines, interleaved with command replies):
+//   MD BOOK <sym> <seq> <BID|ASK> <px> <qty> <orders>   qty 0 = level gone
+//   MD TRADE <sym> <seq> <qty>@<px> <BUY|SELL>          aggressor side
+//   MD TRADES_GAP <sym> <from> <to>                     fetch with TRADES SINCE
+//   MD FILL <sym> <seq> <order id> <qty>@<px> <BUY|SELL>  one of the client's orders
+//                                                       traded (its side); seq as MD TRADE
+//
+// A pushed line queues behind replies still owed on its connection (see
+// Connection::send), so the fills of an order always follow its ack.
+//
+// A subscriber whose socket backlog passes kConflateBytes stops receiving
+// every change: level updates are merged per price (latest wins) and trade
+// prints collapse into a gap notice. Fills are never conflated: they are
+// the client's own, and there is no other way to learn them. The merged
+// state goes out once the backlog has drained, so a slow reader never stalls the loop or grows
+// without bound.
+class MarketFeed {
+public:
+  static constexpr size_t kConflateBytes = 256 * 1024;
+
+  explicit MarketFeed(EventLoop& loop) : loop_(loop) {}
+
+  // loop thread
+  void add(const std::shared_ptr<Subscription>& sub);
+  bool remove(const Connection* conn, const SymbolBook* book, FeedKind kind);
+  void on_update(const MarketUpdate& u);
+  void on_drain(const std::shared_ptr<Connection>& conn);
+
+  // snapshot reply for a new subscription, built on the matching thread
+  static std::string snapshot(Subscription& sub, SymbolBook& book, size_t depth);
+
+private:
+  EventLoop& loop_;
+  std::vector<std::shared_ptr<Subscription>> subs_;
+
+  void emit_dirty(Connection& c, Subscription& s);
+  static void drop(Subscription& s);
+};
+
+} // namespace ts
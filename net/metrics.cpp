@@ -0,0 +1,52 @@
+#include "net/metrics.hpp"
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace ts {
+
+void MetricsWriter::head(std::string_view name, std::string_view labels) {
+  out_.append(name);
+  if (!labels.empty()) {
+    out_ += '{';
+    out_.append(labels);
+    out_ += '}';
+  }
+  out_ += ' ';
+}
+
+void MetricsWriter::type(std::string_view name, std::string_view kind) {
+  out_ += "# TYPE ";
+  out_.append(name);
+  out_ += ' ';
+  out_.append(kind);
+  out_ += '\n';
+  ++lines_;
+}
+
+void MetricsWriter::value(std::string_view name, std::string_view labels, uint64_t v) {
+  head(name, labels);
+  out_ += std::to_string(v);
+  out_ += '\n';
+  ++lines_;
+}
+
+void MetricsWriter::value(std::string_view name, std::string_view labels, double v) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.3f", v);
+  head(name, labels);
+  out_ += buf;
+  out_ += '\n';
+  ++lines_;
+}
+
+void MetricsWriter::summary(std::string_view name, std::string_view labels, const LatencyHistogram& h) {
+  static const std::pair<const char*, double> kQuantiles[] = {{"0.5", 0.5}, {"0.99", 0.99}, {"0.999", 0.999}, {"1", 1.0}};
+  std::string sep = labels.empty() ? "" : ",";
+  for (const auto& [label, q] : kQuantiles)
+    value(name, std::string(labels) + sep + "quantile=\"" + label + "\"", h.percentile(q));
+  value(std::string(name) + "_count", labels, h.count());
+  value(std::string(name) + "_sum", labels, static_cast<uint64_t>(h.mean() * static_cast<double>(h.count())));
+}
+
+} // namespace ts
@@ -0,0 +1,81 @@
+#pragma once
+#include "common/latency_histogram.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ts {
+
+// Hot-path metrics. Every counter and histogram has exactly one writing
+// thread (the matching shard it belongs to), which updates it with a plain
+// relaxed load + store: no locked instruction, no shared cache line with
+// other writers. Readers (STATS, the metrics port) load the same atomics
+// from any thread and merge the shards; a read may be a few samples behind.
+
+enum class CmdKind : uint8_t { Limit, Market, Cancel, Replace, Query };
+constexpr size_t kCmdKinds = 5;
+constexpr const char* kCmdKindNames[kCmdKinds] = {"limit", "market", "cancel", "replace", "query"};
+
+// single-writer counter
+class StatCounter {
+public:
+  void add(uint64_t n = 1) { v_.store(v_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+  uint64_t load() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> v_{0};
+};
+
+// LatencyHistogram buckets as single-writer counters
+class StatHistogram {
+public:
+  void record(uint64_t ns) { counts_[LatencyHistogram::bucket_of(ns)].add(); }
+  void add_to(LatencyHistogram& h) const {
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) h.add_bucket(i, counts_[i].load());
+  }
+
+private:
+  std::array<StatCounter, LatencyHistogram::kBuckets> counts_;
+};
+
+// Written by one matching thread only.
+struct alignas(64) ShardMetrics {
+  std::array<StatCounter, kCmdKinds> commands;
+  StatCounter fills;
+  // accepted by the event loop -> executed (queueing, journal, matching)
+  std::array<StatHistogram, kCmdKinds> latency;
+  // execution on the matching thread alone
+  std::array<StatHistogram, kCmdKinds> service;
+
+  // t_accept: loop thread, when the line was parsed; t_start/t_end: around execution
+  void record(CmdKind k, uint64_t t_accept, uint64_t t_start, uint64_t t_end) {
+    size_t i = static_cast<size_t>(k);
+    commands[i].add();
+    latency[i].record(t_end - t_accept);
+    service[i].record(t_end - t_start);
+  }
+};
+
+// Appends lines in the Prometheus text format: name{labels} value
+class MetricsWriter {
+public:
+  explicit MetricsWriter(std::string& out) : out_(out) {}
+
+  void type(std::string_view name, std::string_view kind);  // # TYPE line
+  void value(std::string_view name, std::string_view labels, uint64_t v);
+  void value(std::string_view name, std::string_view labels, double v);
+  // summary: quantile lines plus _count and _sum
+  void summary(std::string_view name, std::string_view labels, const LatencyHistogram& h);
+
+  size_t lines() const { return lines_; }
+
+private:
+  std::string& out_;
+  size_t lines_{0};
+  void head(std::string_view name, std::string_view labels);
+};
+
+} // namespace ts
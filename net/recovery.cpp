@@ -0,0 +1,182 @@
+#include "net/recovery.hpp"
+#include "common/logger.hpp"
+#include <cstring>
+
+namespace ts {
+
+template <class T>
+static void put(std::string& out, const T& v) {
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+namespace {
+
+// bounds-checked reads over a blob
+struct Reader {
+  const char* p;
+  const char* end;
+
+  template <class T>
+  bool get(T& v) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+  bool bytes(size_t n, std::string_view& v) {
+    if (static_cast<size_t>(end - p) < n) return false;
+    v = std::string_view(p, n);
+    p += n;
+    return true;
+  }
+};
+
+} // namespace
+
+std::string encode_book(const SymbolBook& b) {
+  std::string out;
+  char name[16];
+  std::memset(name, 0, sizeof(name));
+  copy_field(name, b.symbol);
+  out.append(name, sizeof(name));
+  put(out, b.engine.next_order_id());
+  put(out, b.book_seq);
+  put(out, b.trades.last_seq());
+  size_t count_at = out.size();
+  put(out, uint64_t{0});
+
+  uint64_t n = 0;
+  b.engine.for_each_resting([&](const Order& o) {
+    SnapshotOrder s{};
+    s.id = o.id;
+    s.px = o.px;
+    s.qty = o.qty;
+    s.client = o.client;
+    s.side = static_cast<uint8_t>(o.side);
+    put(out, s);
+    ++n;
+  });
+  std::memcpy(&out[count_at], &n, sizeof(n));
+  return out;
+}
+
+std::string encode_positions(const SymbolBook& b) {
+  std::string out;
+  char name[16];
+  std::memset(name, 0, sizeof(name));
+  copy_field(name, b.symbol);
+  out.append(name, sizeof(name));
+  put(out, static_cast<int64_t>(b.positions.last_px()));
+  size_t count_at = out.size();
+  put(out, uint64_t{0});
+
+  uint64_t n = 0;
+  b.positions.for_each([&](ClientId client, const Position& p) {
+    SnapshotPosition s{};
+    s.client = client;
+    s.qty = p.qty;
+    s.cash = p.cash;
+    s.open_cost = p.open_cost;
+    s.realized = p.realized;
+    s.volume = p.volume;
+    s.fills = p.fills;
+    put(out, s);
+    ++n;
+  });
+  std::memcpy(&out[count_at], &n, sizeof(n));
+  return out;
+}
+
+std::string make_snapshot(const ClientTable& clients, const std::vector<std::string>& books,
+                          const std::vector<std::string>& positions) {
+  std::string out;
+  uint32_t count = static_cast<uint32_t>(clients.size() - 1);  // id 0 is "no client"
+  put(out, count);
+  for (ClientId id = 1; id <= count; ++id) {
+    const std::string& name = clients.name(id);
+    put(out, static_cast<uint32_t>(name.size()));
+    out += name;
+  }
+  put(out, static_cast<uint32_t>(books.size()));
+  for (const auto& b : books) out += b;
+  put(out, static_cast<uint32_t>(positions.size()));
+  for (const auto& p : positions) out += p;
+  return out;
+}
+
+bool restore_snapshot(const std::string& blob, SymbolRegistry& registry, ClientTable& clients,
+                      std::string& err) {
+  Reader r{blob.data(), blob.data() + blob.size()};
+  uint32_t count = 0;
+  if (!r.get(count)) { err = "truncated client table"; return false; }
+  for (ClientId id = 1; id <= count; ++id) {
+    uint32_t len = 0;
+    std::string_view name;
+    if (!r.get(len) || !r.bytes(len, name)) { err = "truncated client table"; return false; }
+    // ids are dense and the table starts empty, so they come back unchanged
+    if (clients.intern(name) != id) { err = "client table out of order"; return false; }
+  }
+
+  uint32_t books = 0;
+  if (!r.get(books)) { err = "truncated book count"; return false; }
+  for (uint32_t i = 0; i < books; ++i) {
+    std::string_view name;
+    uint64_t next_id = 0, book_seq = 0, trade_seq = 0, orders = 0;
+    if (!r.bytes(16, name) || !r.get(next_id) || !r.get(book_seq) || !r.get(trade_seq) || !r.get(orders)) {
+      err = "truncated book header";
+      return false;
+    }
+    if (orders > static_cast<uint64_t>(r.end - r.p) / sizeof(SnapshotOrder)) {
+      err = "truncated order list";
+      return false;
+    }
+    SymbolBook* b = registry.find(name.substr(0, strnlen(name.data(), name.size())));
+    for (uint64_t k = 0; k < orders; ++k) {
+      SnapshotOrder s;
+      r.get(s);
+      if (!b) continue;
+      Order o;
+      o.id = s.id;
+      o.px = s.px;
+      o.qty = s.qty;
+      o.client = s.client;
+      o.side = static_cast<Side>(s.side);
+      b->engine.restore_resting(o);
+    }
+    if (!b) continue;
+    if (next_id > b->engine.next_order_id()) b->engine.set_next_order_id(next_id);
+    b->book_seq = book_seq;
+    b->trades.resume_at(trade_seq);
+  }
+
+  if (r.p == r.end) return true;  // written before positions were kept
+  if (!r.get(books)) { err = "truncated position count"; return false; }
+  for (uint32_t i = 0; i < books; ++i) {
+    std::string_view name;
+    int64_t last_px = 0;
+    uint64_t held = 0;
+    if (!r.bytes(16, name) || !r.get(last_px) || !r.get(held) ||
+        held > static_cast<uint64_t>(r.end - r.p) / sizeof(SnapshotPosition)) {
+      err = "truncated positions";
+      return false;
+    }
+    SymbolBook* b = registry.find(name.substr(0, strnlen(name.data(), name.size())));
+    if (b) b->positions.set_last_px(last_px);
+    for (uint64_t k = 0; k < held; ++k) {
+      SnapshotPosition s;
+      r.get(s);
+      if (!b || s.client > count) continue;
+      Position p;
+      p.qty = s.qty;
+      p.cash = s.cash;
+      p.open_cost = s.open_cost;
+      p.realized = s.realized;
+      p.volume = s.volume;
+      p.fills = s.fills;
+      b->positions.restore(s.client, p);
+    }
+  }
+  return true;
+}
+
+} // namespace ts
@@ -0,0 +1,54 @@
+#pragma once
+#include "common/client_table.hpp"
+#include "net/symbol_registry.hpp"
+#include <string>
+#include <vector>
+
+namespace ts {
+
+// Snapshot blob for InputJournal (all fields little-endian):
+//
+//   u32 client_count, then for ids 1..count: u32 length + name bytes
+//   u32 book_count, then per book:
+//     char symbol[16], u64 next_order_id, u64 book_seq, u64 trade_seq,
+//     u64 order_count, SnapshotOrder * order_count (bids then asks, priority order)
+//   u32 book_count, then per book (absent in older snapshots):
+//     char symbol[16], i64 last_px, u64 position_count, SnapshotPosition * position_count
+//
+// Books are matched by symbol name on load, so a restart may add or drop
+// instruments; state for a symbol no longer configured is skipped.
+
+struct SnapshotOrder {
+  uint64_t id;
+  int64_t px;       // ticks
+  int32_t qty;
+  uint32_t client;  // id in the snapshot's client table
+  uint8_t side;
+  uint8_t pad[7];
+};
+static_assert(sizeof(SnapshotOrder) == 32, "snapshot order layout");
+
+struct SnapshotPosition {
+  uint32_t client;
+  uint32_t pad;
+  int64_t qty;
+  int64_t cash;
+  int64_t open_cost;
+  int64_t realized;
+  uint64_t volume;
+  uint64_t fills;
+};
+static_assert(sizeof(SnapshotPosition) == 56, "snapshot position layout");
+
+// matching thread of b: b's sections of a snapshot (orders, positions)
+std::string encode_book(const SymbolBook& b);
+std::string encode_positions(const SymbolBook& b);
+// join sections into a snapshot, with every client name interned so far
+std::string make_snapshot(const ClientTable& clients, const std::vector<std::string>& books,
+                          const std::vector<std::string>& positions);
+// at startup, before the matching threads run: rebuild clients and books;
+// false (with err) if the blob is malformed
+bool restore_snapshot(const std::string& blob, SymbolRegistry& registry, ClientTable& clients,
+                      std::string& err);
+
+} // namespace ts
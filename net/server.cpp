@@ -1,12 +1,23 @@
 #include "net/server.hpp"
+#include "net/recovery.hpp"
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <future>
 #include <iostream>
 #include <sstream>
-#include <iomanip>
 
 namespace ts {
 
@@ -15,8 +26,162 @@ static bool set_reuseaddr(int fd) {
   return setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == 0;
 }
 
-Server::Server(int port) : port_(port) {}
-Server::~Server() { stop(); }
+// Lift the soft open-file limit to the hard one so thousands of sessions fit.
+static void raise_fd_limit() {
+  rlimit rl{};
+  if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur >= rl.rlim_max) return;
+  rl.rlim_cur = rl.rlim_max;
+  (void)setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+static CmdKind cmd_kind(const InputCommand& in) {
+  switch (in.kind) {
+    case InputKind::NewLimit: return CmdKind::Limit;
+    case InputKind::NewMarket: return CmdKind::Market;
+    case InputKind::Replace: return CmdKind::Replace;
+    default: return CmdKind::Cancel;
+  }
+}
+
+static std::string format_book(const TopOfBook& top, const PriceScale& sc) {
+  std::ostringstream msg;
+  msg << "BOOK ";
+  if (top.has_bid) msg << "BID " << top.bid_qty << "@" << sc.format(top.bid_px);
+  else msg << "BID none";
+  msg << " | ";
+  if (top.has_ask) msg << "ASK " << top.ask_qty << "@" << sc.format(top.ask_px);
+  else msg << "ASK none";
+  return msg.str();
+}
+
+static std::string format_depth(const std::vector<DepthLevel>& bids, const std::vector<DepthLevel>& asks,
+                                const PriceScale& sc) {
+  std::ostringstream msg;
+  msg << "DEPTH";
+  auto side = [&](const char* tag, const std::vector<DepthLevel>& lv) {
+    msg << ' ' << tag;
+    if (lv.empty()) msg << " none";
+    for (const auto& l : lv) msg << ' ' << l.qty << '@' << sc.format(l.px) << '/' << l.orders;
+  };
+  side("BID", bids);
+  msg << " |";
+  side("ASK", asks);
+  return msg.str();
+}
+
+// Price positions are marked at: the mid, else the one side quoted, else
+// the last fill (ticks; a mid may fall between two)
+static double mark_ticks(const SymbolBook& b) {
+  TopOfBook top = b.engine.top();
+  if (top.has_bid && top.has_ask) return 0.5 * static_cast<double>(top.bid_px + top.ask_px);
+  if (top.has_bid) return static_cast<double>(top.bid_px);
+  if (top.has_ask) return static_cast<double>(top.ask_px);
+  return static_cast<double>(b.positions.last_px());
+}
+
+// MARK text: a mid between two ticks gets one more digit
+static std::string format_mark(const PriceScale& sc, double mark) {
+  return sc.format(mark, mark == std::floor(mark) ? 0 : 1);
+}
+
+// QTY q CASH c REALIZED r UNREALIZED u PNL t VOLUME v, money in price units
+// (at least cents, more when the tick is finer)
+static std::string format_position(const Position& p, double mark, const PriceScale& sc) {
+  auto money = [&](double ticks) { return ticks / sc.ticks_per_unit; };
+  int d = std::max(2, sc.decimals);
+  char buf[192];
+  std::snprintf(buf, sizeof(buf), "QTY %lld CASH %.*f REALIZED %.*f UNREALIZED %.*f PNL %.*f VOLUME %llu",
+                static_cast<long long>(p.qty), d, money(static_cast<double>(p.cash)), d,
+                money(static_cast<double>(p.realized)), d, money(p.unrealized(mark)), d, money(p.pnl(mark)),
+                static_cast<unsigned long long>(p.volume));
+  return buf;
+}
+
+// BARS <k> <sym> <seconds> LAST <seq>, then k lines
+//   BAR <seq> <start_ms> O <px> H <px> L <px> C <px> V <qty> VWAP <px> N <trades> MID <px> SPREAD <px> AVG_SPREAD <px>
+// LAST is the newest closed bar; a line with a higher seq is the open bar,
+// whose values still change. "-" marks a value not known yet.
+static std::string format_bars(const SymbolBook& b, const BarSeries& s, uint64_t since, size_t limit) {
+  std::vector<Bar> bars;
+  s.read(since, limit, bars);
+  const PriceScale& sc = b.engine.scale();
+  std::string out = "BARS " + std::to_string(bars.size()) + " " + b.symbol + " " +
+                    std::to_string(s.interval_ns() / 1000000000ull) + " LAST " + std::to_string(s.last_closed());
+  auto px = [&](const char* tag, double ticks, bool known, int extra = 0) {
+    out += ' ';
+    out += tag;
+    out += ' ';
+    out += known ? sc.format(ticks, extra) : "-";
+  };
+  for (const Bar& bar : bars) {
+    out += "\nBAR " + std::to_string(bar.seq) + " " + std::to_string(bar.start_ns / 1000000);
+    bool traded = bar.close != 0;
+    px("O", static_cast<double>(bar.open), traded);
+    px("H", static_cast<double>(bar.high), traded);
+    px("L", static_cast<double>(bar.low), traded);
+    px("C", static_cast<double>(bar.close), traded);
+    out += " V " + std::to_string(bar.volume);
+    px("VWAP", bar.volume ? static_cast<double>(bar.notional) / static_cast<double>(bar.volume) : 0.0, bar.volume > 0, 2);
+    out += " N " + std::to_string(bar.trades);
+    bool quoted = bar.bid && bar.ask;
+    px("MID", 0.5 * static_cast<double>(bar.bid + bar.ask), quoted, 2);
+    px("SPREAD", static_cast<double>(bar.ask - bar.bid), quoted);
+    px("AVG_SPREAD", bar.quotes ? static_cast<double>(bar.spread_sum) / static_cast<double>(bar.quotes) : 0.0,
+       bar.quotes > 0, 2);
+  }
+  return out;
+}
+
+// TRADES:        TRADE qty@px lines for the newest `limit` trades
+// TRADES SINCE:  TRADES <count> LAST <seq> [MISSED <n>] then TRADE <seq> qty@px lines
+// Built as one string so the reply goes out in a single write.
+static std::string format_trades(const SymbolBook& b, bool incremental, uint64_t since, size_t limit) {
+  std::vector<TradeTick> ticks;
+  ticks.reserve(std::min<size_t>(limit, 256));
+  if (!incremental) {
+    uint64_t last = b.trades.last_seq();
+    since = last > limit ? last - limit : 0;
+  }
+  uint64_t missed = b.trades.read(since, limit, ticks);
+  const PriceScale& sc = b.engine.scale();
+
+  std::string out;
+  out.reserve(32 + ticks.size() * 32);
+  if (incremental) {
+    out += "TRADES " + std::to_string(ticks.size()) + " LAST " +
+           std::to_string(ticks.empty() ? since : ticks.back().seq);
+    if (missed) out += " MISSED " + std::to_string(missed);
+  } else if (ticks.empty()) {
+    return "(no trades)";
+  }
+  for (const TradeTick& t : ticks) {
+    if (!out.empty()) out += '\n';
+    out += "TRADE ";
+    if (incremental) { out += std::to_string(t.seq); out += ' '; }
+    out += std::to_string(t.qty);
+    out += '@';
+    out += sc.format(t.px);
+  }
+  return out;
+}
+
+Server::Server(const ServerConfig& cfg)
+    : port_(cfg.port), io_threads_(cfg.io_threads ? cfg.io_threads : 1),
+      registry_(cfg.symbols, cfg.match_threads, cfg.match_cpus, cfg.trade_history, cfg.pool),
+      journal_cfg_(cfg.journal), log_(cfg.log), metrics_port_(cfg.metrics_port) {
+  for (size_t i = 0; i < registry_.threads(); ++i) shard_metrics_.push_back(std::make_unique<ShardMetrics>());
+  for (const auto& b : registry_.books()) b->bars.configure(cfg.bar_intervals, cfg.bar_history);
+}
+
+Server::~Server() {
+  stop();
+  // same order as the end of run(): nothing may call into a stopped stage
+  join_metrics();
+  for (auto& l : loops_) l->stop();
+  if (journal_) journal_->stop();
+  registry_.stop();
+  log_.stop();
+}
 
 bool Server::setup_listener() {
   listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
@@ -30,34 +195,275 @@ bool Server::setup_listener() {
   if (::bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) < 0) {
     perror("bind"); return false;
   }
-  if (::listen(listen_fd_, 16) < 0) { perror("listen"); return false; }
+  if (::listen(listen_fd_, SOMAXCONN) < 0) { perror("listen"); return false; }
   return true;
 }
 
+std::vector<JournalSymbol> Server::journal_symbols() const {
+  std::vector<JournalSymbol> symbols;
+  for (const auto& b : registry_.books()) {
+    JournalSymbol js{};
+    copy_field(js.name, b->symbol);
+    js.ticks_per_unit = b->engine.scale().ticks_per_unit;
+    symbols.push_back(js);
+  }
+  return symbols;
+}
+
 void Server::init_logs() {
   session_id_ = std::to_string(now_ns());
-  (void)log_trades_.open("logs/" + session_id_ + "_trades.csv",
-    {"ts_ns","maker_id","taker_id","qty","px",
-     "maker_client","taker_client","maker_side","taker_side"});
-  (void)log_book_.open("logs/" + session_id_ + "_book.csv",
-    {"ts_ns","has_bid","bid_px","bid_qty","has_ask","ask_px","ask_qty"});
+  if (!log_.open_journal("logs/" + session_id_ + "_trades.bin", std::stoull(session_id_), journal_symbols()))
+    std::cerr << "warning: cannot open trade journal in logs/\n";
+  (void)log_.open_book_csv("logs/" + session_id_ + "_book.csv",
+    {"ts_ns","has_bid","bid_px","bid_qty","has_ask","ask_px","ask_qty","symbol"});
+  log_.set_client_names(&clients_);
+  log_.start();
+}
+
+// Startup, before any thread touches the books: newest snapshot, then every
+// command journaled after it, executed exactly as the first time. A replay
+// is folded into a fresh snapshot so the next restart does not repeat it.
+bool Server::recover() {
+  if (journal_cfg_.dir.empty()) return true;
+  const std::string& dir = journal_cfg_.dir;
+  uint64_t seq = 0;
+  std::string blob, err;
+  if (load_latest_snapshot(dir, seq, blob) && !restore_snapshot(blob, registry_, clients_, err)) {
+    std::cerr << "cannot restore snapshot in " << dir << ": " << err << "\n";
+    return false;
+  }
+  size_t replayed = 0;
+  uint64_t last = replay_input(dir, seq, [&](const InputCommand& logged, std::string_view symbol,
+                                             std::string_view client) {
+    SymbolBook* b = registry_.find(symbol);
+    if (!b) return;  // instrument no longer configured
+    InputCommand cmd = logged;
+    cmd.symbol = b->id;
+    cmd.client = clients_.intern(client);
+    (void)execute(*b, cmd, false);
+    ++replayed;
+  });
+  // replayed fills happened before the restart, not now: no bars for them
+  for (const auto& b : registry_.books()) b->bars.clear();
+  bool covered = last == seq;
+  if (!covered) covered = write_snapshot_file(dir, last, quiet_snapshot());
+
+  journal_ = std::make_unique<InputJournal>(journal_cfg_, clients_, journal_symbols());
+  if (!journal_->open(last + 1)) {
+    std::cerr << "cannot open input journal in " << dir << "\n";
+    return false;
+  }
+  if (covered) prune_journal(dir, last);  // the segment just opened retires the rest
+  journal_->set_checkpoint_handler([this](uint64_t at) { checkpoint(at); });
+  if (last > 0) {
+    size_t resting = 0;
+    for (const auto& b : registry_.books()) resting += b->engine.resting_count();
+    std::cout << "recovered " << dir << " up to command " << last << " (" << replayed
+              << " replayed, " << resting << " resting orders)\n";
+  }
+  return true;
+}
+
+namespace {
+struct SnapshotJob {
+  uint64_t seq;
+  std::vector<std::string> parts;
+  std::vector<std::string> positions;
+  std::atomic<size_t> left;
+};
+} // namespace
+
+// Journal writer thread, right after the continuations up to seq were posted:
+// each book encodes itself on its own matching thread (so behind exactly
+// those commands), and the last one to finish hands the snapshot back.
+void Server::checkpoint(uint64_t seq) {
+  auto job = std::make_shared<SnapshotJob>();
+  job->seq = seq;
+  job->parts.resize(registry_.books().size());
+  job->positions.resize(job->parts.size());
+  job->left.store(job->parts.size());
+  for (const auto& book : registry_.books()) {
+    registry_.post(*book, [this, job](SymbolBook& b) {
+      job->parts[b.id] = encode_book(b);
+      job->positions[b.id] = encode_positions(b);
+      if (job->left.fetch_sub(1) == 1)
+        journal_->save_snapshot(job->seq, make_snapshot(clients_, job->parts, job->positions));
+    });
+  }
+}
+
+// every book read from this thread: only while no matching thread runs
+std::string Server::quiet_snapshot() const {
+  std::vector<std::string> parts, positions;
+  for (const auto& b : registry_.books()) {
+    parts.push_back(encode_book(*b));
+    positions.push_back(encode_positions(*b));
+  }
+  return make_snapshot(clients_, parts, positions);
+}
+
+std::string Server::execute(SymbolBook& b, const InputCommand& cmd, bool live) {
+  const std::string id = std::to_string(cmd.order_id);
+  switch (cmd.kind) {
+    case InputKind::NewLimit: {
+      uint64_t assigned = b.engine.next_order_id();
+      if (!b.engine.new_limit_order(cmd.client, cmd.side, cmd.qty, cmd.px, b.fills)) return "ERROR bad price";
+      record_trades(b, b.fills, live);
+      return "OK " + std::to_string(assigned);
+    }
+    case InputKind::NewMarket: {
+      uint64_t assigned = b.engine.next_order_id();
+      if (!b.engine.new_market_order(cmd.client, cmd.side, cmd.qty, b.fills)) return "ERROR bad quantity";
+      record_trades(b, b.fills, live);
+      return "OK " + std::to_string(assigned);
+    }
+    case InputKind::Cancel: {
+      bool ok = b.engine.cancel(cmd.order_id);
+      publish(b, {});
+      return (ok ? "CANCELLED " : "NOT FOUND ") + id;
+    }
+    case InputKind::Replace: {
+      ReplaceResult r = b.engine.replace(cmd.order_id, cmd.qty, cmd.px, b.fills);
+      record_trades(b, b.fills, live);
+      switch (r) {
+        case ReplaceResult::NotFound: return "NOT FOUND " + id;
+        case ReplaceResult::Rejected: return "ERROR bad price " + id;
+        case ReplaceResult::Amended: return "AMENDED " + id;   // queue position kept
+        case ReplaceResult::Requeued: return "REPLACED " + id;
+      }
+      break;
+    }
+    case InputKind::CancelAll: {
+      size_t n = b.engine.cancel_all(cmd.client);
+      publish(b, {});
+      return "CANCELLED ALL " + std::to_string(n);
+    }
+  }
+  return "ERROR unknown command";
+}
+
+void Server::record_trades(SymbolBook& book, const std::vector<Trade>& trades, bool log) {
+  LogRecord rec;
+  rec.kind = LogKind::Trade;
+  rec.trade.symbol_id = book.id;
+  const uint64_t wall = trades.empty() ? 0 : wall_ns();
+  for (auto& tr : trades) {
+    book.trades.push(tr.px, tr.qty, tr.taker_side);
+    book.positions.on_fill(tr);
+    rec.ts_ns = now_ns();
+    book.bars.on_trade(wall, tr.px, tr.qty);
+    rec.trade.maker_id = tr.maker_id;
+    rec.trade.taker_id = tr.taker_id;
+    rec.trade.qty = tr.qty;
+    rec.trade.px = tr.px;
+    rec.trade.maker_side = tr.maker_side;
+    rec.trade.taker_side = tr.taker_side;
+    rec.trade.maker_client = tr.maker_client;
+    rec.trade.taker_client = tr.taker_client;
+    if (log) log_.log(rec);
+  }
+  if (log) shard_metrics_[book.shard]->fills.add(trades.size());
+  publish(book, trades);
+}
+
+// Stamps the book change and, when anyone listens, hands the changed levels
+// and new prints (with the fills behind them) to every event loop. The
+// update is built once and shared.
+void Server::publish(SymbolBook& book, const std::vector<Trade>& trades) {
+  const size_t new_trades = trades.size();
+  const auto& touched = book.engine.touched();
+  if (touched.empty() && new_trades == 0) return;
+  if (!touched.empty()) {
+    ++book.book_seq;
+    book.bars.on_quote(wall_ns(), book.engine.top());
+  }
+  if (book.subscribers.load(std::memory_order_relaxed) == 0) return;
+
+  auto u = std::make_shared<MarketUpdate>();
+  u->book = &book;
+  u->book_seq = book.book_seq;
+  u->levels.reserve(touched.size());
+  for (const auto& t : touched) {
+    DepthLevel l = book.engine.level(t.side, t.px);
+    u->levels.push_back(LevelChange{t.side, t.px, l.qty, l.orders});
+  }
+  if (new_trades) {
+    uint64_t last = book.trades.last_seq();
+    book.trades.read(last - std::min<uint64_t>(last, new_trades), new_trades, u->trades);
+    u->fills = trades;
+    u->fills_seq = last - new_trades + 1;
+  }
+  for (size_t i = 0; i < loops_.size(); ++i) {
+    MarketFeed* f = feeds_[i].get();
+    loops_[i]->post([f, u] { f->on_update(*u); });
+  }
+}
+
+MarketFeed& Server::feed_for(const Connection& c) {
+  for (size_t i = 0; i < loops_.size(); ++i) {
+    if (loops_[i].get() == c.loop()) return *feeds_[i];
+  }
+  return *feeds_.front();  // not reached: every connection belongs to a loop
 }
 
 void Server::run() {
+  std::signal(SIGPIPE, SIG_IGN);  // a vanished peer must not kill the exchange
+  raise_fd_limit();
   if (!setup_listener()) return;
+  if (!recover()) return;
   init_logs();
+  registry_.start();
+  if (journal_) journal_->start();
+  for (size_t i = 0; i < io_threads_; ++i) {
+    loops_.push_back(std::make_unique<EventLoop>(
+      [this](const std::shared_ptr<Connection>& c) { c->send("WELCOME AUM TradeSim. Type HELP for commands."); },
+      [this](const std::shared_ptr<Connection>& c, std::string_view line) { handle_line(c, line); }));
+    feeds_.push_back(std::make_unique<MarketFeed>(*loops_.back()));
+    MarketFeed* f = feeds_.back().get();
+    loops_.back()->set_drain_handler([f](const std::shared_ptr<Connection>& c) { f->on_drain(c); });
+    if (!loops_.back()->start()) return;
+  }
   running_.store(true);
-  std::cout << "Server listening on port " << port_ << "  (session " << session_id_ << ")\n";
+  started_ns_ = now_ns();
+  if (metrics_port_ > 0) {
+    if (setup_metrics_listener()) metrics_thread_ = std::thread([this] { serve_metrics(); });
+    else std::cerr << "warning: metrics port " << metrics_port_ << " unavailable\n";
+  }
+  std::cout << "Server listening on port " << port_ << "  (session " << session_id_ << ", "
+            << registry_.books().size() << " symbols on " << registry_.threads()
+            << " matching threads, " << loops_.size() << " I/O loops)\n";
 
+  // accept here and spread connections over the event loops round-robin
+  size_t next = 0;
   while (running_.load()) {
     int cfd = ::accept(listen_fd_, nullptr, nullptr);
     if (cfd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno == EMFILE || errno == ENFILE) { perror("accept"); usleep(10000); continue; }
       if (running_.load()) perror("accept");
       break;
     }
-    client_threads_.emplace_back([this, cfd]() { handle_client(cfd); });
+    int one = 1;
+    (void)setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    loops_[next++ % loops_.size()]->adopt(cfd);
   }
-  for (auto& t : client_threads_) if (t.joinable()) t.join();
+  join_metrics();  // may be waiting on the books
+  for (auto& l : loops_) l->stop();
+  if (journal_) journal_->stop();  // flushes and dispatches what was accepted
+  registry_.stop();
+  if (journal_) {
+    // books are quiet now: a final snapshot makes the next start instant
+    uint64_t last = journal_->last_seq();
+    if (write_snapshot_file(journal_cfg_.dir, last, quiet_snapshot()))
+      prune_journal(journal_cfg_.dir, last);  // the open segment goes at the next start
+    InputJournalStats js = journal_->stats();
+    std::cout << "journal: " << js.records << " commands in " << js.commits << " commits, "
+              << js.snapshots << " snapshots\n";
+  }
+  log_.stop();
+  LogStats ls = log_.stats();
+  std::cout << "log: " << ls.written << " written, " << ls.dropped << " dropped, "
+            << ls.blocked << " blocked\n";
 }
 
 void Server::stop() {
@@ -67,161 +473,503 @@ void Server::stop() {
     ::close(listen_fd_);
     listen_fd_ = -1;
   }
+  std::lock_guard<std::mutex> lk(metrics_mu_);
+  if (metrics_fd_ >= 0) ::shutdown(metrics_fd_, SHUT_RDWR);  // wakes accept; closed by join_metrics
 }
 
-bool Server::write_line(int fd, const std::string& s) {
-  std::string line = s + "\n";
-  return ::send(fd, line.data(), line.size(), 0) == (ssize_t)line.size();
+namespace {
+struct BookStats {
+  size_t resting{0};
+  size_t bid_levels{0};
+  size_t ask_levels{0};
+  uint64_t trades{0};
+  int subscribers{0};
+};
+
+struct StatsJob {
+  std::vector<BookStats> books;
+  std::atomic<size_t> left{0};
+  bool with_types{false};
+  std::function<void(std::string)> done;
+};
+} // namespace
+
+void Server::collect_stats(bool with_types, std::function<void(std::string)> done) {
+  auto job = std::make_shared<StatsJob>();
+  job->books.resize(registry_.books().size());
+  job->left.store(job->books.size());
+  job->with_types = with_types;
+  job->done = std::move(done);
+  for (const auto& book : registry_.books()) {
+    registry_.post(*book, [this, job](SymbolBook& b) {
+      BookStats& bs = job->books[b.id];
+      bs.resting = b.engine.resting_count();
+      bs.bid_levels = b.engine.levels(Side::Buy);
+      bs.ask_levels = b.engine.levels(Side::Sell);
+      bs.trades = b.trades.last_seq();
+      bs.subscribers = b.subscribers.load(std::memory_order_relaxed);
+      if (job->left.fetch_sub(1) != 1) return;
+
+      // last book read: every other field is an atomic readable from here
+      std::string out;
+      MetricsWriter m(out);
+      auto type = [&](const char* name, const char* kind) { if (job->with_types) m.type(name, kind); };
+      auto label = [](const char* k, const std::string& v) { return std::string(k) + "=\"" + v + "\""; };
+
+      type("tradesim_uptime_seconds", "gauge");
+      m.value("tradesim_uptime_seconds", "", static_cast<double>(now_ns() - started_ns_) / 1e9);
+      type("tradesim_clients", "gauge");
+      m.value("tradesim_clients", "", static_cast<uint64_t>(clients_.size() - 1));
+      type("tradesim_connections", "gauge");
+      for (size_t i = 0; i < loops_.size(); ++i)
+        m.value("tradesim_connections", label("loop", std::to_string(i)), static_cast<uint64_t>(loops_[i]->connections()));
+      type("tradesim_lines_total", "counter");
+      for (size_t i = 0; i < loops_.size(); ++i)
+        m.value("tradesim_lines_total", label("loop", std::to_string(i)), loops_[i]->lines());
+
+      type("tradesim_commands_total", "counter");
+      for (size_t s = 0; s < shard_metrics_.size(); ++s)
+        for (size_t k = 0; k < kCmdKinds; ++k)
+          m.value("tradesim_commands_total", label("shard", std::to_string(s)) + "," + label("kind", kCmdKindNames[k]),
+                  shard_metrics_[s]->commands[k].load());
+      type("tradesim_fills_total", "counter");
+      for (size_t s = 0; s < shard_metrics_.size(); ++s)
+        m.value("tradesim_fills_total", label("shard", std::to_string(s)), shard_metrics_[s]->fills.load());
+      type("tradesim_shard_queue", "gauge");
+      for (size_t s = 0; s < shard_metrics_.size(); ++s)
+        m.value("tradesim_shard_queue", label("shard", std::to_string(s)), static_cast<uint64_t>(registry_.queued(s)));
+
+      // latency summaries per command kind, merged over the shards
+      type("tradesim_command_latency_ns", "summary");
+      type("tradesim_command_service_ns", "summary");
+      for (size_t k = 0; k < kCmdKinds; ++k) {
+        auto h = std::make_unique<LatencyHistogram>(), sv = std::make_unique<LatencyHistogram>();
+        for (const auto& sm : shard_metrics_) {
+          sm->latency[k].add_to(*h);
+          sm->service[k].add_to(*sv);
+        }
+        if (h->count() == 0) continue;
+        m.summary("tradesim_command_latency_ns", label("kind", kCmdKindNames[k]), *h);
+        m.summary("tradesim_command_service_ns", label("kind", kCmdKindNames[k]), *sv);
+      }
+
+      type("tradesim_book_resting_orders", "gauge");
+      type("tradesim_book_levels", "gauge");
+      type("tradesim_book_trades_total", "counter");
+      type("tradesim_book_subscribers", "gauge");
+      for (const auto& book : registry_.books()) {
+        const BookStats& st = job->books[book->id];
+        std::string sym = label("symbol", book->symbol);
+        m.value("tradesim_book_resting_orders", sym, static_cast<uint64_t>(st.resting));
+        m.value("tradesim_book_levels", sym + ",side=\"bid\"", static_cast<uint64_t>(st.bid_levels));
+        m.value("tradesim_book_levels", sym + ",side=\"ask\"", static_cast<uint64_t>(st.ask_levels));
+        m.value("tradesim_book_trades_total", sym, st.trades);
+        m.value("tradesim_book_subscribers", sym, static_cast<uint64_t>(st.subscribers));
+      }
+
+      if (journal_) {
+        InputJournalStats js = journal_->stats();
+        type("tradesim_journal_records_total", "counter");
+        m.value("tradesim_journal_records_total", "", js.records);
+        type("tradesim_journal_commits_total", "counter");
+        m.value("tradesim_journal_commits_total", "", js.commits);
+        type("tradesim_journal_snapshots_total", "counter");
+        m.value("tradesim_journal_snapshots_total", "", js.snapshots);
+      }
+      LogStats ls = log_.stats();
+      type("tradesim_log_records_total", "counter");
+      m.value("tradesim_log_records_total", "state=\"written\"", ls.written);
+      m.value("tradesim_log_records_total", "state=\"dropped\"", ls.dropped);
+      m.value("tradesim_log_records_total", "state=\"blocked\"", ls.blocked);
+      job->done(std::move(out));
+    });
+  }
 }
 
-bool Server::read_line(int fd, std::string& out) {
-  out.clear();
-  char ch;
-  while (true) {
-    ssize_t r = ::recv(fd, &ch, 1, 0);
-    if (r <= 0) return false;
-    if (ch == '\n') break;
-    if (ch != '\r') out.push_back(ch);
-    if (out.size() > 4096) return false;
+bool Server::setup_metrics_listener() {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  set_reuseaddr(fd);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // local scrapers only
+  addr.sin_port = htons(static_cast<uint16_t>(metrics_port_));
+  if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+    ::close(fd);
+    return false;
   }
+  std::lock_guard<std::mutex> lk(metrics_mu_);
+  metrics_fd_ = fd;
   return true;
 }
 
-void Server::handle_client(int cfd) {
-  write_line(cfd, "WELCOME AUM TradeSim. Type HELP for commands.");
-  std::string line;
+// Minimal HTTP/1.0: any request gets the metrics text, then the connection
+// closes. Scrapes are rare, so one blocking connection at a time is enough.
+void Server::serve_metrics() {
+  while (running_.load()) {
+    int fd = ::accept(metrics_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      break;
+    }
+    timeval tv{1, 0};  // a silent client gets its answer after a second
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::string req;
+    char buf[1024];
+    while (req.size() < 8192 && req.find("\r\n\r\n") == std::string::npos && req.find("\n\n") == std::string::npos) {
+      ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+      if (r <= 0) break;
+      req.append(buf, static_cast<size_t>(r));
+    }
+
+    std::promise<std::string> text;
+    auto ready = text.get_future();
+    collect_stats(true, [&text](std::string t) { text.set_value(std::move(t)); });
+    std::string body = ready.get();
+    std::string resp = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    const char* p = resp.data();
+    size_t left = resp.size();
+    while (left > 0) {
+      ssize_t w = ::send(fd, p, left, 0);
+      if (w <= 0) break;
+      p += w;
+      left -= static_cast<size_t>(w);
+    }
+    ::close(fd);
+  }
+}
+
+void Server::join_metrics() {
+  if (metrics_thread_.joinable()) metrics_thread_.join();
+  std::lock_guard<std::mutex> lk(metrics_mu_);
+  if (metrics_fd_ >= 0) ::close(metrics_fd_);
+  metrics_fd_ = -1;
+}
+
+// Runs on the connection's event loop. Anything touching a book is posted
+// to the symbol's matching thread, which answers through Connection::deliver.
+// The line is a view into the receive buffer: lambdas capture parsed values.
+void Server::handle_line(const std::shared_ptr<Connection>& c, std::string_view raw) {
+  std::string_view line = ts::trim_view(raw);
+  if (line.empty()) return;
+  if (c->state) { batch_line(c, raw); return; }  // inside a BATCH
+  TokenViews toks = ts::token_views(line);
+  if (toks.empty()) return;
+
+  std::string_view cmd = toks[0];
+
+  if (cmd == "QUIT" || cmd == "EXIT") { c->closing = true; return; }
 
-  while (read_line(cfd, line)) {
-    line = ts::trim(line);
-    if (line.empty()) continue;
-    auto toks = ts::tokens(line);
-    if (toks.empty()) continue;
+  if (cmd == "HELP") {
+    c->send("Commands: NEW LIMIT/NEW MARKET/REPLACE <id> <qty> @ <px>/CANCEL <id>/CANCEL ALL CLIENT <name>/BATCH <n>/BOOK/DEPTH <n>/TRADES [SINCE <seq>] [LIMIT <n>]/BARS <s> [SINCE <seq>]/POSITION CLIENT <name>/LEADERBOARD [n]/SUBSCRIBE BOOK|TRADES|FILLS CLIENT <name>/UNSUBSCRIBE/SYMBOLS/STATS/QUIT"
+            " (append SYMBOL <name> to pick an instrument)");
+    return;
+  }
 
-    std::string cmd = toks[0];
+  if (cmd == "STATS") {
+    // STATS <n> then n "name{labels} value" lines (the metrics port's format)
+    uint64_t slot = c->reserve();
+    collect_stats(false, [c, slot](std::string text) {
+      size_t n = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+      if (!text.empty()) text.pop_back();
+      c->deliver(slot, "STATS " + std::to_string(n) + "\n" + text);
+    });
+    return;
+  }
 
-    if (cmd == "QUIT" || cmd == "EXIT") break;
+  if (cmd == "SYMBOLS") {
+    std::string msg = "SYMBOLS";
+    for (const auto& b : registry_.books()) msg += " " + b->symbol;
+    c->send(msg);
+    return;
+  }
+
+  std::string_view sym = take_symbol(toks);
+  SymbolBook* book = sym.empty() ? &registry_.default_book() : registry_.find(sym);
+  if (!book) {
+    c->send("ERROR unknown symbol " + std::string(sym));
+    return;
+  }
 
-    if (cmd == "HELP") {
-      write_line(cfd, "Commands: NEW LIMIT/NEW MARKET/BOOK/TRADES/CANCEL/QUIT");
-      continue;
+  // hand one command to the matching thread; fn returns the reply line(s).
+  // Behind a journaled command of this client still in flight, a query
+  // waits its turn in the journal so it sees that command's effect.
+  const uint64_t accepted = now_ns();
+  auto submit = [&](std::function<std::string(SymbolBook&)> fn) {
+    uint64_t slot = c->reserve();
+    auto task = [this, c, slot, accepted, fn = std::move(fn)](SymbolBook& b) {
+      uint64_t start = now_ns();
+      std::string reply = fn(b);
+      shard_metrics_[b.shard]->record(CmdKind::Query, accepted, start, now_ns());
+      c->deliver(slot, std::move(reply));
+    };
+    if (journal_ && c->pending() > 1) {
+      journal_->after([this, book, task = std::move(task)](bool) { registry_.post(*book, task); });
+      return;
     }
+    registry_.post(*book, std::move(task));
+  };
 
-    if (cmd == "BOOK") {
-      TopOfBook top;
-      {
-        std::lock_guard<std::mutex> lk(eng_mu_);
-        top = engine_.top();
-      }
+  // state-changing commands: durable in the journal first, then executed in
+  // journal order; the reply is sent only after the write reached disk
+  auto submit_input = [&](const InputCommand& in) {
+    uint64_t slot = c->reserve();
+    CmdKind kind = cmd_kind(in);
+    auto task = [this, c, slot, in, kind, accepted](SymbolBook& b) {
+      uint64_t start = now_ns();
+      std::string reply = execute(b, in, true);
+      shard_metrics_[b.shard]->record(kind, accepted, start, now_ns());
+      c->deliver(slot, std::move(reply));
+    };
+    if (!journal_) { registry_.post(*book, std::move(task)); return; }
+    journal_->append(in, [this, c, slot, book, task = std::move(task)](bool durable) {
+      if (!durable) { c->deliver(slot, kJournalFailed); return; }
+      registry_.post(*book, task);
+    });
+  };
+
+  if (cmd == "BOOK") {
+    submit([this](SymbolBook& b) {
+      TopOfBook top = b.engine.top();
+      const PriceScale& sc = b.engine.scale();
       // log top-of-book snapshot
-      log_book_.write_row({
-        std::to_string(now_ns()),
-        top.has_bid ? "1" : "0",
-        top.has_bid ? std::to_string(top.bid_px) : "",
-        top.has_bid ? std::to_string(top.bid_qty) : "",
-        top.has_ask ? "1" : "0",
-        top.has_ask ? std::to_string(top.ask_px) : "",
-        top.has_ask ? std::to_string(top.ask_qty) : ""
-      });
+      LogRecord rec;
+      rec.kind = LogKind::Book;
+      rec.ts_ns = now_ns();
+      copy_field(rec.symbol, b.symbol);
+      rec.book.has_bid = top.has_bid;
+      rec.book.has_ask = top.has_ask;
+      rec.book.bid_px = sc.to_px(top.bid_px);
+      rec.book.ask_px = sc.to_px(top.ask_px);
+      rec.book.bid_qty = top.bid_qty;
+      rec.book.ask_qty = top.ask_qty;
+      log_.log(rec);
+      return format_book(top, sc);
+    });
+    return;
+  }
 
-      std::ostringstream msg;
-      msg << "BOOK ";
-      if (top.has_bid) msg << "BID " << top.bid_qty << "@" << std::fixed << std::setprecision(2) << top.bid_px;
-      else msg << "BID none";
-      msg << " | ";
-      if (top.has_ask) msg << "ASK " << top.ask_qty << "@" << std::fixed << std::setprecision(2) << top.ask_px;
-      else msg << "ASK none";
-      write_line(cfd, msg.str());
-      continue;
-    }
-
-    if (cmd == "TRADES") {
-      std::lock_guard<std::mutex> lk(trades_mu_);
-      if (trades_.empty()) write_line(cfd, "(no trades)");
-      else {
-        for (auto& tr : trades_) {
-          write_line(cfd, "TRADE " + std::to_string(tr.qty) + "@" + std::to_string(tr.px));
-        }
+  if (cmd == "DEPTH") {
+    // DEPTH <n>  ->  DEPTH BID qty@px/orders ... | ASK qty@px/orders ...
+    size_t n = 5;
+    if (toks.size() >= 2) {
+      unsigned long v = 0;
+      auto r = std::from_chars(toks[1].data(), toks[1].data() + toks[1].size(), v);
+      if (r.ec != std::errc() || r.ptr != toks[1].data() + toks[1].size() || v == 0) {
+        c->send("ERROR usage: DEPTH <n>");
+        return;
       }
-      continue;
+      n = std::min<unsigned long>(v, kMaxDepth);
     }
+    submit([n](SymbolBook& b) {
+      std::vector<DepthLevel> bids, asks;
+      b.engine.depth(n, bids, asks);
+      return format_depth(bids, asks, b.engine.scale());
+    });
+    return;
+  }
 
-    // Order entry
-    try {
-      if (toks.size() >= 8 && toks[0]=="NEW" && toks[1]=="LIMIT" && toks[6]=="CLIENT") {
-        Side side = (toks[2]=="BUY") ? Side::Buy : Side::Sell;
-        int qty = std::stoi(toks[3]);
-        double px = std::stod(toks[5]);
-        std::string client = toks[7];
+  if (cmd == "TRADES") {
+    // TRADES [SINCE <seq>] [LIMIT <n>]
+    bool incremental = false;
+    uint64_t since = 0;
+    size_t limit = kDefaultTradesLimit;
+    for (size_t i = 1; i < toks.size(); i += 2) {
+      bool ok = i + 1 < toks.size();
+      if (ok && toks[i] == "SINCE") { ok = parse_int(toks[i + 1], since); incremental = true; }
+      else if (ok && toks[i] == "LIMIT") ok = parse_int(toks[i + 1], limit) && limit > 0;
+      else ok = false;
+      if (!ok) { c->send("ERROR usage: TRADES [SINCE <seq>] [LIMIT <n>]"); return; }
+    }
+    limit = std::min(limit, kMaxTradesLimit);
+    // The ring is readable from this thread, so fills never wait on a reader.
+    // Only when this client still has commands queued on the matching thread
+    // does the read go there too, so it sees the client's own fills.
+    if (c->pending() == 0) {
+      c->send(format_trades(*book, incremental, since, limit));
+    } else {
+      submit([incremental, since, limit](SymbolBook& b) {
+        return format_trades(b, incremental, since, limit);
+      });
+    }
+    return;
+  }
 
-        std::vector<Trade> trades;
-        {
-          std::lock_guard<std::mutex> lk(eng_mu_);
-          trades = engine_.new_limit_order(client, side, qty, px);
-        }
-        if (!trades.empty()) {
-          std::lock_guard<std::mutex> lk(trades_mu_);
-          for (auto& tr : trades) {
-            trades_.push_back(tr);
-            log_trades_.write_row({
-              std::to_string(now_ns()),
-              std::to_string(tr.maker_id),
-              std::to_string(tr.taker_id),
-              std::to_string(tr.qty),
-              std::to_string(tr.px),
-              tr.maker_client,
-              tr.taker_client,
-              (tr.maker_side==Side::Buy?"BUY":"SELL"),
-              (tr.taker_side==Side::Buy?"BUY":"SELL")
-            });
-          }
-        }
-        write_line(cfd, "OK");
-      } else if (toks.size() >= 6 && toks[0]=="NEW" && toks[1]=="MARKET" && toks[4]=="CLIENT") {
-        Side side = (toks[2]=="BUY") ? Side::Buy : Side::Sell;
-        int qty = std::stoi(toks[3]);
-        std::string client = toks[5];
-
-        std::vector<Trade> trades;
-        {
-          std::lock_guard<std::mutex> lk(eng_mu_);
-          trades = engine_.new_market_order(client, side, qty);
-        }
-        if (!trades.empty()) {
-          std::lock_guard<std::mutex> lk(trades_mu_);
-          for (auto& tr : trades) {
-            trades_.push_back(tr);
-            log_trades_.write_row({
-              std::to_string(now_ns()),
-              std::to_string(tr.maker_id),
-              std::to_string(tr.taker_id),
-              std::to_string(tr.qty),
-              std::to_string(tr.px),
-              tr.maker_client,
-              tr.taker_client,
-              (tr.maker_side==Side::Buy?"BUY":"SELL"),
-              (tr.taker_side==Side::Buy?"BUY":"SELL")
-            });
-          }
-        }
-        write_line(cfd, "OK");
-      } else if (cmd == "CANCEL" && toks.size() >= 2) {
-        uint64_t oid = std::stoull(toks[1]);
-        bool ok;
-        {
-          std::lock_guard<std::mutex> lk(eng_mu_);
-          ok = engine_.cancel(oid);
-        }
-        write_line(cfd, ok ? "CANCELLED" : "NOT FOUND");
-      } else {
-        write_line(cfd, "ERROR unknown command");
+  if (cmd == "BARS") {
+    // BARS <seconds> [SINCE <seq>] [LIMIT <n>]: bars after seq, for polling like TRADES SINCE
+    uint32_t seconds = 0;
+    uint64_t since = 0;
+    size_t limit = kDefaultBarsLimit;
+    bool ok = toks.size() >= 2 && parse_int(toks[1], seconds) && book->bars.find(seconds);
+    for (size_t i = 2; ok && i < toks.size(); i += 2) {
+      ok = i + 1 < toks.size();
+      if (ok && toks[i] == "SINCE") ok = parse_int(toks[i + 1], since);
+      else if (ok && toks[i] == "LIMIT") ok = parse_int(toks[i + 1], limit) && limit > 0;
+      else ok = false;
+    }
+    if (!ok) {
+      std::string intervals;
+      for (const auto& s : book->bars.series()) intervals += (intervals.empty() ? "" : "|") + std::to_string(s.interval_ns() / 1000000000ull);
+      c->send("ERROR usage: BARS <" + intervals + "> [SINCE <seq>] [LIMIT <n>] [SYMBOL <name>]");
+      return;
+    }
+    limit = std::min(limit, kMaxTradesLimit);
+    submit([seconds, since, limit](SymbolBook& b) { return format_bars(b, *b.bars.find(seconds), since, limit); });
+    return;
+  }
+
+  if (cmd == "POSITION") {
+    // POSITION CLIENT <name>  ->  POSITION <name> <sym> QTY .. PNL .. VOLUME .. MARK <px>
+    if (toks.size() != 3 || toks[1] != "CLIENT") { c->send("ERROR usage: POSITION CLIENT <name> [SYMBOL <name>]"); return; }
+    ClientId client = clients_.find(toks[2]);
+    submit([this, client, name = std::string(toks[2])](SymbolBook& b) {
+      static const Position kFlat{};
+      const Position* p = client == ClientTable::kNone ? nullptr : b.positions.find(client);
+      double mark = mark_ticks(b);
+      return "POSITION " + name + " " + b.symbol + " " + format_position(p ? *p : kFlat, mark, b.engine.scale()) +
+             " MARK " + format_mark(b.engine.scale(), mark);
+    });
+    return;
+  }
+
+  if (cmd == "LEADERBOARD") {
+    // LEADERBOARD [n]  ->  LEADERBOARD <k> <sym> MARK <px>, then k lines
+    // "<rank> <name> QTY .. PNL .. VOLUME ..", best PnL first
+    size_t n = kDefaultLeaders;
+    if (toks.size() > 2 || (toks.size() == 2 && (!parse_int(toks[1], n) || n == 0))) {
+      c->send("ERROR usage: LEADERBOARD [n] [SYMBOL <name>]");
+      return;
+    }
+    n = std::min(n, kMaxLeaders);
+    submit([this, n](SymbolBook& b) {
+      double mark = mark_ticks(b);
+      std::vector<std::pair<double, ClientId>> ranked;
+      b.positions.for_each([&](ClientId id, const Position& p) { ranked.emplace_back(p.pnl(mark), id); });
+      size_t k = std::min(n, ranked.size());
+      std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(k), ranked.end(),
+                        [](const auto& a, const auto& z) { return a.first > z.first || (a.first == z.first && a.second < z.second); });
+      std::string out =
+          "LEADERBOARD " + std::to_string(k) + " " + b.symbol + " MARK " + format_mark(b.engine.scale(), mark);
+      for (size_t i = 0; i < k; ++i) {
+        out += "\n" + std::to_string(i + 1) + " " + clients_.name(ranked[i].second) + " ";
+        out += format_position(*b.positions.find(ranked[i].second), mark, b.engine.scale());
       }
-    } catch (...) {
-      write_line(cfd, "ERROR parsing command");
+      return out;
+    });
+    return;
+  }
+
+  if (cmd == "SUBSCRIBE" || cmd == "UNSUBSCRIBE") {
+    // SUBSCRIBE BOOK|TRADES|FILLS: snapshot reply, then MD lines pushed as the book moves
+    FeedKind kind;
+    ClientId client = 0;
+    bool fills_args = toks.size() == 4 && toks[2] == "CLIENT";  // SUBSCRIBE FILLS CLIENT <name>
+    if (toks.size() == 2 && toks[1] == "BOOK") kind = FeedKind::Book;
+    else if (toks.size() == 2 && toks[1] == "TRADES") kind = FeedKind::Trades;
+    else if (toks.size() >= 2 && toks[1] == "FILLS" && (cmd == "UNSUBSCRIBE" ? toks.size() == 2 : fills_args)) {
+      kind = FeedKind::Fills;
+      if (fills_args && (client = clients_.intern(toks[3])) == ClientTable::kNone) {
+        c->send("ERROR bad client");
+        return;
+      }
+    } else {
+      c->send("ERROR usage: " + std::string(cmd) + " BOOK|TRADES|FILLS CLIENT <name> [SYMBOL <name>]");
+      return;
     }
+    MarketFeed& feed = feed_for(*c);
+    bool had = feed.remove(c.get(), book, kind);
+    if (cmd == "UNSUBSCRIBE") {
+      c->send(had ? "UNSUBSCRIBED " + std::string(toks[1]) + " " + book->symbol
+                  : "ERROR not subscribed");
+      return;
+    }
+    auto sub = std::make_shared<Subscription>(c, book, kind);
+    sub->client = client;
+    feed.add(sub);
+    submit([sub](SymbolBook& b) { return MarketFeed::snapshot(*sub, b, SIZE_MAX); });
+    return;
   }
 
-  ::close(cfd);
+  if (cmd == "BATCH") {
+    // BATCH <n>, then n order lines for this symbol
+    size_t n = 0;
+    if (toks.size() != 2 || !parse_int(toks[1], n) || n == 0 || n > kMaxBatch) {
+      c->send("ERROR usage: BATCH <1-" + std::to_string(kMaxBatch) + "> [SYMBOL <name>]");
+      return;
+    }
+    auto batch = std::make_unique<PendingBatch>();
+    batch->book = book;
+    batch->expected = n;
+    batch->accepted = accepted;
+    c->state = std::move(batch);
+    return;
+  }
+
+  // Order entry
+  InputCommand in;
+  std::string err;
+  if (!parse_input(toks, *book, in, err)) { c->send(err); return; }
+  submit_input(in);
 }
 
-} // namespace ts
+// One line of an open BATCH: parsed like a single command and held until the
+// batch is complete. A bad line becomes that entry's error and does not stop
+// the others.
+void Server::batch_line(const std::shared_ptr<Connection>& c, std::string_view raw) {
+  auto& batch = static_cast<PendingBatch&>(*c->state);
+  std::string_view line = ts::trim_view(raw);
+  TokenViews toks = ts::token_views(line);
+  std::string_view sym = take_symbol(toks);
+  InputCommand in;
+  std::string err;
+  if (toks.empty()) err = "ERROR empty line";
+  else if (!sym.empty() && sym != batch.book->symbol) err = "ERROR batch is for " + batch.book->symbol;
+  else parse_input(toks, *batch.book, in, err);
+  batch.entries.push_back(BatchEntry{in, std::move(err)});
+  if (batch.entries.size() < batch.expected) return;
 
+  std::unique_ptr<ConnectionState> done = std::move(c->state);
+  submit_batch(c, std::move(static_cast<PendingBatch&>(*done)));
+}
+
+// The whole batch is one matching-thread task (and one journal commit):
+// the orders run back to back with nothing from other sessions in between.
+void Server::submit_batch(const std::shared_ptr<Connection>& c, PendingBatch batch) {
+  uint64_t slot = c->reserve();
+  SymbolBook* book = batch.book;
+  uint64_t accepted = batch.accepted;
+  auto entries = std::make_shared<std::vector<BatchEntry>>(std::move(batch.entries));
+  auto task = [this, c, slot, accepted, entries](SymbolBook& b) {
+    std::string reply = "BATCH " + std::to_string(entries->size());
+    for (const BatchEntry& e : *entries) {
+      reply += '\n';
+      if (!e.error.empty()) { reply += e.error; continue; }
+      uint64_t start = now_ns();
+      reply += execute(b, e.cmd, true);
+      shard_metrics_[b.shard]->record(cmd_kind(e.cmd), accepted, start, now_ns());
+    }
+    c->deliver(slot, std::move(reply));
+  };
+  if (!journal_) { registry_.post(*book, std::move(task)); return; }
+  std::vector<InputCommand> cmds;
+  for (const BatchEntry& e : *entries)
+    if (e.error.empty()) cmds.push_back(e.cmd);
+  auto post = [this, c, slot, book, entries, task = std::move(task)](bool durable) {
+    if (durable) { registry_.post(*book, task); return; }
+    std::string reply = "BATCH " + std::to_string(entries->size());
+    for (const BatchEntry& e : *entries) reply += '\n' + (e.error.empty() ? std::string(kJournalFailed) : e.error);
+    c->deliver(slot, std::move(reply));
+  };
+  if (cmds.empty()) journal_->after(std::move(post));
+  else journal_->append_batch(cmds, std::move(post));
+}
+
+// NEW LIMIT / NEW MARKET / CANCEL / REPLACE / CANCEL ALL for book, or the error reply
+bool Server::parse_input(const TokenViews& toks, const SymbolBook& book, InputCommand& in, std::string& err) {
+  if (!parse_command(toks, clients_, in, err)) return false;
+  in.symbol = book.id;
+  return true;
+}
+
+} // namespace ts
@@ -1,50 +1,134 @@
 #pragma once
+#include "common/client_table.hpp"
+#include "common/input_journal.hpp"
 #include "common/types.hpp"
 #include "common/util.hpp"
 #include "common/logger.hpp"
-#include "engine/matching_engine.hpp"
+#include "net/event_loop.hpp"
+#include "net/market_feed.hpp"
+#include "net/metrics.hpp"
+#include "net/symbol_registry.hpp"
 #include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 namespace ts {
 
+struct ServerConfig {
+  int port{5555};
+  std::vector<SymbolSpec> symbols{{"AUM", 0.01}};  // first one is the default
+  size_t match_threads{1};
+  std::vector<int> match_cpus;                      // pin matching threads (Linux)
+  size_t io_threads{1};                             // event loops serving sockets
+  size_t trade_history{65536};                      // trades kept per symbol for TRADES
+  PoolConfig pool;                                  // resting-order slab per symbol
+  LogConfig log;                                    // trade/book CSV writer
+  InputJournalConfig journal;                       // crash recovery; dir "" turns it off
+  int metrics_port{0};                              // plain-text metrics on 127.0.0.1 (0: off)
+  std::vector<uint32_t> bar_intervals{1, 10, 60};   // seconds; BARS <interval>
+  size_t bar_history{1440};                         // bars kept per interval and symbol
+};
+
+// An order line of an open BATCH: the parsed command, or why it was rejected
+struct BatchEntry {
+  InputCommand cmd;
+  std::string error;
+};
+
+// BATCH <n> on a connection: the next n lines are collected here
+struct PendingBatch : ConnectionState {
+  SymbolBook* book{nullptr};
+  size_t expected{0};
+  uint64_t accepted{0};  // when the BATCH line was read
+  std::vector<BatchEntry> entries;
+};
+
 class Server {
 public:
-  explicit Server(int port);
+  explicit Server(const ServerConfig& cfg);
   ~Server();
 
   void run();   // blocks until stop
   void stop();  // stops listening
 
 private:
+  static constexpr size_t kMaxDepth = 100;          // cap for DEPTH <n>
+  static constexpr size_t kDefaultTradesLimit = 1000;  // TRADES without LIMIT
+  static constexpr size_t kMaxTradesLimit = 10000;
+  static constexpr size_t kMaxBatch = 256;             // order lines per BATCH
+  static constexpr size_t kDefaultLeaders = 10;        // LEADERBOARD without n
+  static constexpr size_t kMaxLeaders = 1000;
+  static constexpr size_t kDefaultBarsLimit = 1000;    // BARS without LIMIT
+  // reply to orders once the input journal failed: nothing more is accepted
+  static constexpr const char* kJournalFailed = "ERROR journal write failed";
+
   int port_;
+  size_t io_threads_;
   int listen_fd_{-1};
   std::atomic<bool> running_{false};
-  std::vector<std::thread> client_threads_;
 
-  // Matching engine + guards
-  MatchingEngine engine_;
-  std::mutex eng_mu_;
+  // Client names seen this session; orders and trades carry the ids
+  ClientTable clients_;
 
-  // Simple in-memory trade cache (still keep for TRADES command)
-  std::vector<Trade> trades_;
-  std::mutex trades_mu_;
+  // One matching engine per symbol, each owned by a matching thread
+  SymbolRegistry registry_;
+
+  // Write-ahead command journal + snapshots (null when disabled); declared
+  // after registry_ because its writer posts to the matching threads
+  InputJournalConfig journal_cfg_;
+  std::unique_ptr<InputJournal> journal_;
 
   // Logging
   std::string session_id_;
-  CsvLogger log_trades_;
-  CsvLogger log_book_;
+  AsyncLogger log_;  // fed from the matching threads, written by its own thread
+
+  // Hot-path counters and latencies, one block per matching thread
+  std::vector<std::unique_ptr<ShardMetrics>> shard_metrics_;
+  uint64_t started_ns_{0};
+  int metrics_port_;
+  // set before the metrics thread starts, closed after it is joined;
+  // the mutex keeps stop()'s shutdown away from that close
+  int metrics_fd_{-1};
+  std::mutex metrics_mu_;
+  std::thread metrics_thread_;
+
+  // Market data fan-out, one per event loop (must outlive loops_)
+  std::vector<std::unique_ptr<MarketFeed>> feeds_;
+
+  // Event loops own the client sockets (declared last: stopped first)
+  std::vector<std::unique_ptr<EventLoop>> loops_;
 
-  void handle_client(int client_fd);
+  void handle_line(const std::shared_ptr<Connection>& c, std::string_view line);
+  void batch_line(const std::shared_ptr<Connection>& c, std::string_view line);
+  void submit_batch(const std::shared_ptr<Connection>& c, PendingBatch batch);
+  // an order-entry line into in; false with the error reply in err
+  bool parse_input(const TokenViews& toks, const SymbolBook& book, InputCommand& in, std::string& err);
   bool setup_listener();
-  bool write_line(int fd, const std::string& s);
-  bool read_line(int fd, std::string& out);
 
-  void init_logs();  // open CSVs with headers once
+  void init_logs();  // open CSVs with headers once, start the writer
+  bool recover();    // load the newest snapshot, replay the journal, open a new segment
+  void checkpoint(uint64_t seq);  // journal writer: snapshot every book at seq
+  std::string quiet_snapshot() const;  // startup/shutdown, matching threads stopped
+  std::vector<JournalSymbol> journal_symbols() const;
+
+  // matching thread: run one journaled command and return its reply; replay
+  // passes live=false so recovered fills are not logged a second time
+  std::string execute(SymbolBook& book, const InputCommand& cmd, bool live);
+  void record_trades(SymbolBook& book, const std::vector<Trade>& trades, bool log);
+  void publish(SymbolBook& book, const std::vector<Trade>& trades);  // feed subscribers
+  MarketFeed& feed_for(const Connection& c);
+
+  // any thread: read every book on its matching thread, then call done with
+  // the metrics text (on the matching thread of the last book read)
+  void collect_stats(bool with_types, std::function<void(std::string)> done);
+  bool setup_metrics_listener();
+  void serve_metrics();  // metrics port thread: one scrape per connection
+  void join_metrics();   // stop() first
 };
 
 } // namespace ts
-
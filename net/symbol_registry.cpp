@@ -0,0 +1,94 @@
+#include "net/symbol_registry.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ts {
+
+void MatchShard::start(int cpu) {
+  thread_ = std::thread([this] { loop(); });
+#ifdef __linux__
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    (void)pthread_setaffinity_np(thread_.native_handle(), sizeof(set), &set);
+  }
+#else
+  (void)cpu; // affinity is best-effort; not available on macOS
+#endif
+}
+
+void MatchShard::stop() {
+  stopping_.store(true);
+  {
+    std::lock_guard<std::mutex> lk(park_mu_);
+    park_cv_.notify_one();
+  }
+  if (thread_.joinable()) thread_.join();
+}
+
+void MatchShard::post(std::function<void()> task) {
+  while (!queue_.try_push(std::move(task))) std::this_thread::yield();  // task is moved only on success
+  // pairs with the fence in loop(): either the thread sees this task before
+  // parking, or we see it parked and wake it
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (idle_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lk(park_mu_);
+    park_cv_.notify_one();
+  }
+}
+
+void MatchShard::loop() {
+  std::function<void()> task;
+  while (true) {
+    while (queue_.try_pop(task)) {
+      task();
+      task = nullptr;  // drop captures (connections, buffers) right away
+    }
+    if (stopping_.load()) {
+      if (queue_.empty()) return;  // stopping and drained
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(park_mu_);
+    idle_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    park_cv_.wait(lk, [this] { return !queue_.empty() || stopping_.load(); });
+    idle_.store(false, std::memory_order_relaxed);
+  }
+}
+
+SymbolRegistry::SymbolRegistry(const std::vector<SymbolSpec>& symbols, size_t threads,
+                               const std::vector<int>& cpus, size_t trade_history,
+                               const PoolConfig& pool)
+    : cpus_(cpus) {
+  if (threads == 0) threads = 1;
+  if (threads > symbols.size() && !symbols.empty()) threads = symbols.size();
+  for (size_t i = 0; i < threads; ++i) shards_.push_back(std::make_unique<MatchShard>());
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    books_.push_back(std::make_unique<SymbolBook>(symbols[i], static_cast<uint16_t>(i), i % threads,
+                                                  trade_history, pool));
+    by_name_[symbols[i].name] = books_.back().get();
+  }
+}
+
+void SymbolRegistry::start() {
+  for (size_t i = 0; i < shards_.size(); ++i)
+    shards_[i]->start(cpus_.empty() ? -1 : cpus_[i % cpus_.size()]);
+}
+
+void SymbolRegistry::stop() {
+  for (auto& s : shards_) s->stop();
+}
+
+SymbolBook* SymbolRegistry::find(std::string_view symbol) {
+  auto it = by_name_.find(std::string(symbol));  // symbol names fit in SSO
+  return it == by_name_.end() ? nullptr : it->second;
+}
+
+void SymbolRegistry::post(SymbolBook& book, std::function<void(SymbolBook&)> f) {
+  shards_[book.shard]->post([&book, f = std::move(f)] { f(book); });
+}
+
+} // namespace ts
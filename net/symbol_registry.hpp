@@ -0,0 +1,108 @@
+#pragma once
+#include "common/mpsc_ring.hpp"
+#include "common/types.hpp"
+#include "engine/matching_engine.hpp"
+#include "engine/position_book.hpp"
+#include "net/bar_series.hpp"
+#include "net/trade_ring.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ts {
+
+struct SymbolSpec {
+  std::string name;
+  double tick_size{0.01};
+};
+
+// Per-instrument state. Only the matching thread that owns the symbol
+// touches it, so none of these fields need a lock.
+struct SymbolBook {
+  SymbolBook(const SymbolSpec& spec, uint16_t index, size_t shard_index, size_t trade_history,
+             const PoolConfig& pool)
+      : symbol(spec.name), id(index), engine(spec.tick_size, 4096, pool), trades(trade_history),
+        shard(shard_index) {}
+
+  std::string symbol;
+  uint16_t id;  // position in the registry; the journal's symbol number
+  MatchingEngine engine;
+  std::vector<Trade> fills;  // reused fill sink for every order on this book
+  TradeRing trades;  // recent trades for TRADES; readable from any thread
+  PositionBook positions;  // per-client position and PnL, updated per fill
+  BarSet bars;             // OHLCV/VWAP/spread bars, fed by fills and book changes
+  size_t shard;
+
+  // market data feed (see market_feed.hpp)
+  uint64_t book_seq{0};             // matching thread: bumped on every level change
+  std::atomic<int> subscribers{0};  // live BOOK/TRADES subscriptions
+};
+
+// One matching thread, the only thread that touches its books. Commands
+// arrive through a lock-free MPSC ring, so posting is one CAS and the
+// matching thread never takes a lock while there is work. The mutex and
+// condition variable only park the thread when the ring is empty: a
+// producer takes them just when it finds the thread idle.
+class MatchShard {
+public:
+  static constexpr size_t kQueueCapacity = 1 << 16;  // tasks in flight per shard
+
+  MatchShard() : queue_(kQueueCapacity) {}
+  ~MatchShard() { stop(); }
+
+  void start(int cpu);  // cpu < 0: no pinning
+  void stop();          // runs whatever is queued, then joins
+  // any thread; when the ring is full the caller yields until there is room
+  void post(std::function<void()> task);
+  size_t queued() const { return queue_.size_approx(); }
+
+private:
+  MpscRing<std::function<void()>> queue_;
+  std::atomic<bool> idle_{false};      // consumer parked (or about to)
+  std::atomic<bool> stopping_{false};
+  std::mutex park_mu_;
+  std::condition_variable park_cv_;
+  std::thread thread_;
+
+  void loop();
+};
+
+// Owns one SymbolBook per instrument and the matching threads they are
+// pinned to (round-robin in declaration order).
+class SymbolRegistry {
+public:
+  // cpus: CPU ids for the matching threads (reused cyclically); empty = no pinning
+  // trade_history: trades kept per symbol for TRADES
+  // pool: resting-order storage preallocated per symbol
+  SymbolRegistry(const std::vector<SymbolSpec>& symbols, size_t threads,
+                 const std::vector<int>& cpus, size_t trade_history, const PoolConfig& pool = {});
+  ~SymbolRegistry() { stop(); }
+
+  void start();
+  void stop();
+
+  SymbolBook* find(std::string_view symbol);
+  SymbolBook& default_book() { return *books_.front(); }
+  const std::vector<std::unique_ptr<SymbolBook>>& books() const { return books_; }
+  size_t threads() const { return shards_.size(); }
+  size_t queued(size_t shard) const { return shards_[shard]->queued(); }
+
+  // queue f(book) on the book's matching thread
+  void post(SymbolBook& book, std::function<void(SymbolBook&)> f);
+
+private:
+  std::vector<std::unique_ptr<SymbolBook>> books_;
+  std::unordered_map<std::string, SymbolBook*> by_name_;
+  std::vector<std::unique_ptr<MatchShard>> shards_;
+  std::vector<int> cpus_;
+};
+
+} // namespace ts
@@ -0,0 +1,87 @@
+#pragma once
+#include "common/types.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ts {
+
+struct TradeTick {
+  uint64_t seq{0};  // per-symbol, starts at 1
+  Price px{0};      // ticks
+  int qty{0};
+  Side taker_side{Side::Buy};
+};
+
+// Fixed-capacity history of one symbol's trades. Only the symbol's matching
+// thread appends; any thread may read. Each slot works as a tiny seqlock:
+// its sequence number is cleared before and stamped after the payload, so
+// a reader can tell when a slot was overwritten while it was copying.
+class TradeRing {
+public:
+  explicit TradeRing(size_t capacity) : cap_(capacity ? capacity : 1), slots_(new Slot[cap_]) {}
+
+  size_t capacity() const { return cap_; }
+  uint64_t last_seq() const { return last_.load(std::memory_order_acquire); }
+
+  // before the first push: continue numbering after seq (state restored at
+  // startup); the earlier trades read as missed
+  void resume_at(uint64_t seq) { last_.store(seq, std::memory_order_release); }
+
+  // matching thread only; returns the trade's sequence number
+  uint64_t push(Price px, int qty, Side taker_side) {
+    uint64_t seq = last_.load(std::memory_order_relaxed) + 1;
+    Slot& s = slots_[seq % cap_];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.px.store(px, std::memory_order_relaxed);
+    s.qty.store(qty, std::memory_order_relaxed);
+    s.side.store(static_cast<uint8_t>(taker_side), std::memory_order_relaxed);
+    s.seq.store(seq, std::memory_order_release);
+    last_.store(seq, std::memory_order_release);
+    return seq;
+  }
+
+  // Appends trades with seq > since (oldest first, at most limit) to out.
+  // Returns how many newer-than-since trades had already been overwritten.
+  uint64_t read(uint64_t since, size_t limit, std::vector<TradeTick>& out) const {
+    uint64_t last = last_seq();
+    if (since >= last) return 0;
+    uint64_t oldest = last >= cap_ ? last - cap_ + 1 : 1;
+    uint64_t first = since + 1 > oldest ? since + 1 : oldest;
+    uint64_t missed = first - (since + 1);
+    for (uint64_t seq = first; seq <= last && limit > 0; ++seq) {
+      const Slot& s = slots_[seq % cap_];
+      TradeTick t;
+      uint64_t before = s.seq.load(std::memory_order_acquire);
+      t.px = s.px.load(std::memory_order_relaxed);
+      t.qty = s.qty.load(std::memory_order_relaxed);
+      t.taker_side = static_cast<Side>(s.side.load(std::memory_order_relaxed));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (before != seq || s.seq.load(std::memory_order_relaxed) != seq) {
+        ++missed;  // lapped by the writer while reading
+        continue;
+      }
+      t.seq = seq;
+      out.push_back(t);
+      --limit;
+    }
+    return missed;
+  }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<int64_t> px{0};
+    std::atomic<int32_t> qty{0};
+    std::atomic<uint8_t> side{0};
+  };
+
+  size_t cap_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> last_{0};
+};
+
+} // namespace ts
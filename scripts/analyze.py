@@ -1,40 +1,16 @@
 #!/usr/bin/env python3
-import os, glob, csv, math
+import os, csv, math
+import journal
 
 LOG_DIR = os.path.join(os.path.dirname(__file__), "..", "logs")
 
 def newest_session_prefix():
-    files = glob.glob(os.path.join(LOG_DIR, "*_trades.csv"))
-    if not files:
-        return None
-    # filenames look like logs/1693512345678901234_trades.csv
-    # extract the numeric prefix
-    pairs = []
-    for f in files:
-        base = os.path.basename(f)
-        sess = base.split("_")[0]
-        if sess.isdigit():
-            pairs.append((int(sess), sess))
-    if not pairs:
-        return None
-    pairs.sort(reverse=True)
-    return pairs[0][1]
+    sessions = journal.list_sessions(LOG_DIR)
+    return str(sessions[0]) if sessions else None
 
 def load_trades(session):
-    path = os.path.join(LOG_DIR, f"{session}_trades.csv")
-    trades = []
-    if not os.path.exists(path):
-        return trades
-    with open(path, newline="") as fp:
-        r = csv.DictReader(fp)
-        for row in r:
-            try:
-                ts = int(row["ts_ns"])
-                qty = int(row["qty"])
-                px  = float(row["px"])
-                trades.append((ts, qty, px))
-            except Exception:
-                pass
+    # binary journal when present (mapped, no parsing); CSV for older sessions
+    trades = journal.load_rows(session, LOG_DIR, names=["ts_ns", "qty", "px"])
     trades.sort(key=lambda x: x[0])
     return trades
 
@@ -1,33 +1,21 @@
 #!/usr/bin/env python3
-import os, glob, math
+import os, math
 import pandas as pd
 import streamlit as st
 from streamlit_autorefresh import st_autorefresh  # << add-on for timed refresh
+import journal
+from trader_client import LineClient
 
 ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 LOG_DIR = os.path.join(ROOT, "logs")
 
 def list_sessions():
-    trades = glob.glob(os.path.join(LOG_DIR, "*_trades.csv"))
-    sess = []
-    for f in trades:
-        base = os.path.basename(f)
-        prefix = base.split("_")[0]
-        if prefix.isdigit():
-            sess.append(int(prefix))
-    return sorted(sess, reverse=True)
+    return journal.list_sessions(LOG_DIR)
 
 @st.cache_data(ttl=5.0)
 def load_trades(session):
-    path = os.path.join(LOG_DIR, f"{session}_trades.csv")
-    if not os.path.exists(path):
-        return pd.DataFrame(columns=["ts_ns","maker_id","taker_id","qty","px",
-                                     "maker_client","taker_client","maker_side","taker_side"])
-    df = pd.read_csv(path)
-    for col in ["maker_client","taker_client","maker_side","taker_side"]:
-        if col not in df.columns:
-            df[col] = ""
-    return df
+    # binary journal when present (mapped, no parsing); CSV for older sessions
+    return pd.DataFrame(journal.load_columns(session, LOG_DIR))
 
 @st.cache_data(ttl=5.0)
 def load_book(session):
@@ -72,6 +60,52 @@ def compute_client_pnl(trades_df, last_mid):
         agg["unreal"] = agg["pos"] * last_mid; agg["mtm"] = agg["cash"] + agg["unreal"]
     return agg.sort_values("mtm", ascending=False)
 
+@st.cache_data(ttl=1.0)
+def fetch_leaderboard(host, port, n=100):
+    # the server keeps positions per fill; one query instead of a log rescan
+    conn = LineClient()
+    try:
+        conn.connect(host, port, timeout=1.0)
+        _, lines = conn.request_lines(f"LEADERBOARD {n}")
+        conn.send_line("QUIT")
+    finally:
+        conn.close()
+    rows = []
+    for line in lines:  # "<rank> <name> QTY q CASH c REALIZED r UNREALIZED u PNL t VOLUME v"
+        tok = line.split()
+        kv = dict(zip(tok[2::2], tok[3::2]))
+        rows.append({"client": tok[1], "pos": int(kv["QTY"]), "cash": float(kv["CASH"]),
+                     "realized": float(kv["REALIZED"]), "unreal": float(kv["UNREALIZED"]),
+                     "mtm": float(kv["PNL"]), "volume": int(kv["VOLUME"])})
+    return pd.DataFrame(rows)
+
+def fetch_bars(host, port, seconds):
+    # O(new bars) per refresh: only bars after the last closed one already held
+    key = f"bars_{host}_{port}_{seconds}"
+    held = st.session_state.get(key, {"last": 0, "rows": []})
+    conn = LineClient()
+    try:
+        conn.connect(host, port, timeout=1.0)
+        head, lines = conn.request_lines(f"BARS {seconds} SINCE {held['last']}")
+        conn.send_line("QUIT")
+    finally:
+        conn.close()
+    last = int(head.split()[5])  # BARS <k> <sym> <seconds> LAST <seq>
+    if last < held["last"]:      # server restarted: numbering starts over
+        st.session_state.pop(key, None)
+        return fetch_bars(host, port, seconds)
+    rows = [r for r in held["rows"] if r["seq"] <= held["last"]]  # previous open bar is replaced
+    for line in lines:  # BAR <seq> <start_ms> O .. H .. L .. C .. V .. VWAP .. N .. MID .. SPREAD .. AVG_SPREAD ..
+        tok = line.split()
+        kv = {k: (float("nan") if v == "-" else float(v)) for k, v in zip(tok[3::2], tok[4::2])}
+        kv.update(seq=int(tok[1]), time=pd.to_datetime(int(tok[2]), unit="ms"))
+        rows.append(kv)
+    st.session_state[key] = {"last": last, "rows": rows}
+    df = pd.DataFrame(rows)
+    if not df.empty:
+        df = df.set_index("time").rename(columns={"MID": "mid", "SPREAD": "spread"})
+    return df
+
 def main():
     st.set_page_config(page_title="TradeSim Dashboard", layout="wide")
     st.title("AUM TradeSim — Live Dashboard")
@@ -85,13 +119,26 @@ def main():
     session = st.sidebar.selectbox("Session", sessions, index=0, format_func=str)
     auto = st.sidebar.checkbox("Auto-refresh", value=True)
     interval_ms = st.sidebar.slider("Refresh interval (ms)", min_value=500, max_value=5000, value=2000, step=500)
+    live = st.sidebar.checkbox("PnL from running server", value=True)
+    host = st.sidebar.text_input("Server host", value="127.0.0.1")
+    port = st.sidebar.number_input("Server port", 1, 65535, value=5555, step=1)
+    bar_seconds = st.sidebar.selectbox("Bar interval (s)", [1, 10, 60], index=0)
     if auto:
         st_autorefresh(interval=interval_ms, key="tradesim_autorefresh")
 
     trades_df = load_trades(session)
     book_df   = load_book(session)
-    mid_df    = compute_mid(book_df)
-    spread_df = compute_spread(book_df)
+    mid_df = spread_df = None
+    if live:
+        try:
+            bars = fetch_bars(host, int(port), bar_seconds)
+            if not bars.empty:
+                mid_df, spread_df = bars[["mid"]], bars[["spread"]]
+        except Exception:
+            pass
+    if mid_df is None:
+        mid_df    = compute_mid(book_df)
+        spread_df = compute_spread(book_df)
 
     # KPIs
     c1, c2, c3, c4 = st.columns(4)
@@ -128,7 +175,14 @@ def main():
 
     # per-client PnL
     st.subheader("Per-client PnL / Position")
-    pnl = compute_client_pnl(trades_df, last_mid)
+    pnl = None
+    if live:
+        try:
+            pnl = fetch_leaderboard(host, int(port))
+        except Exception:
+            st.caption("Server not reachable; PnL computed from the session logs.")
+    if pnl is None:
+        pnl = compute_client_pnl(trades_df, last_mid)
     st.dataframe(pnl, use_container_width=True)
 
 if __name__ == "__main__":
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Reader for the binary trade journal (logs/<session>_trades.bin).
+
+The layout mirrors common/trade_journal.hpp: a 1024-byte header (magic,
+version, symbol table with ticks-per-unit) followed by fixed 88-byte
+records with integer tick prices. With numpy installed the records are
+mapped straight from the file; otherwise they are unpacked with struct.
+Sessions logged before the journal existed only have a _trades.csv, so
+the helpers here also find and read those.
+"""
+import csv, glob, mmap, os, struct
+
+MAGIC = b"TSTRADES"
+VERSION = 1
+HEADER_SIZE = 1024
+RECORD = struct.Struct("<QQQqiHBB24s24s")
+MAX_SYMBOLS = 32
+
+COLUMNS = ["ts_ns", "maker_id", "taker_id", "qty", "px",
+           "maker_client", "taker_client", "maker_side", "taker_side", "symbol"]
+
+try:
+    import numpy as np
+    DTYPE = np.dtype([("ts_ns", "<u8"), ("maker_id", "<u8"), ("taker_id", "<u8"),
+                      ("px", "<i8"), ("qty", "<i4"), ("symbol", "<u2"),
+                      ("maker_side", "u1"), ("taker_side", "u1"),
+                      ("maker_client", "S24"), ("taker_client", "S24")])
+except ImportError:  # pragma: no cover - stdlib fallback
+    np = None
+
+
+def list_sessions(log_dir):
+    """Session ids (ints, newest first) that have a trade journal or trade CSV."""
+    sess = set()
+    for pattern in ("*_trades.bin", "*_trades.csv"):
+        for f in glob.glob(os.path.join(log_dir, pattern)):
+            prefix = os.path.basename(f).split("_")[0]
+            if prefix.isdigit():
+                sess.add(int(prefix))
+    return sorted(sess, reverse=True)
+
+
+def _header(buf):
+    if len(buf) < HEADER_SIZE or buf[:8] != MAGIC:
+        raise ValueError("not a trade journal")
+    version, header_size, record_size, nsym = struct.unpack_from("<IIII", buf, 8)
+    if version != VERSION or header_size != HEADER_SIZE or record_size != RECORD.size or nsym > MAX_SYMBOLS:
+        raise ValueError(f"unsupported trade journal (version {version})")
+    symbols = []
+    for i in range(nsym):
+        name, tpu = struct.unpack_from("<16sd", buf, 64 + 24 * i)
+        symbols.append((name.rstrip(b"\0").decode(), tpu))
+    return symbols
+
+
+def _side(v):
+    return "BUY" if v == 0 else "SELL"
+
+
+def load_columns(session_or_path, log_dir=None, names=COLUMNS):
+    """Trade columns as a dict name -> sequence (numpy arrays when available).
+
+    Accepts a journal path, or a session id plus log_dir (falls back to the
+    session's CSV). Only the requested columns are decoded.
+    """
+    path = session_or_path
+    if log_dir is not None:
+        path = os.path.join(log_dir, f"{session_or_path}_trades.bin")
+        if not os.path.exists(path):
+            return _load_csv_columns(os.path.join(log_dir, f"{session_or_path}_trades.csv"), names)
+    with open(path, "rb") as fp:
+        size = os.fstat(fp.fileno()).st_size
+        if size < HEADER_SIZE:
+            raise ValueError("not a trade journal")
+        buf = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+    symbols = _header(buf)
+    count = (size - HEADER_SIZE) // RECORD.size
+    if np is not None:
+        return _numpy_columns(buf, symbols, count, names)
+
+    cols = {n: [] for n in names}
+    for rec in RECORD.iter_unpack(buf[HEADER_SIZE:HEADER_SIZE + count * RECORD.size]):
+        ts, mid, tid, px, qty, sym, ms, tsd, mc, tc = rec
+        name, tpu = symbols[sym] if sym < len(symbols) else ("", 1.0)
+        row = {"ts_ns": ts, "maker_id": mid, "taker_id": tid, "qty": qty, "px": px / tpu,
+               "maker_client": mc.rstrip(b"\0").decode(), "taker_client": tc.rstrip(b"\0").decode(),
+               "maker_side": _side(ms), "taker_side": _side(tsd), "symbol": name}
+        for n in names:
+            cols[n].append(row[n])
+    return cols
+
+
+def load_rows(session_or_path, log_dir=None, names=COLUMNS):
+    """Like load_columns, but as a list of tuples in the order of names."""
+    cols = load_columns(session_or_path, log_dir, names)
+    seqs = [cols[n].tolist() if hasattr(cols[n], "tolist") else cols[n] for n in names]
+    return list(zip(*seqs))
+
+
+def _numpy_columns(buf, symbols, count, names):
+    recs = np.frombuffer(buf, dtype=DTYPE, count=count, offset=HEADER_SIZE)
+    tpu = np.array([t for _, t in symbols] or [1.0])
+    out = {}
+    for n in names:
+        if n == "px":
+            out[n] = recs["px"] / tpu[np.minimum(recs["symbol"], len(tpu) - 1)]
+        elif n in ("maker_side", "taker_side"):
+            out[n] = np.where(recs[n] == 0, "BUY", "SELL")
+        elif n in ("maker_client", "taker_client"):
+            out[n] = recs[n].astype("U")  # ASCII names; trailing NULs drop off
+        elif n == "symbol":
+            table = np.array([s for s, _ in symbols] or [""])
+            out[n] = table[np.minimum(recs["symbol"], len(table) - 1)]
+        else:
+            out[n] = recs[n]
+    return out
+
+
+def _load_csv_columns(path, names):
+    cols = {n: [] for n in names}
+    if not os.path.exists(path):
+        return cols
+    ints = {"ts_ns", "maker_id", "taker_id", "qty"}
+    with open(path, newline="") as fp:
+        for row in csv.DictReader(fp):
+            try:
+                vals = {n: (int(row[n]) if n in ints else float(row[n]) if n == "px" else row.get(n, ""))
+                        for n in names}
+            except (KeyError, ValueError):
+                continue
+            for n in names:
+                cols[n].append(vals[n])
+    return cols
@@ -1,40 +1,17 @@
 #!/usr/bin/env python3
-import os, glob, csv, math
+import os, csv, math
+import journal
 
 LOG_DIR = os.path.join(os.path.dirname(__file__), "..", "logs")
 
 def newest_session_prefix():
-    files = glob.glob(os.path.join(LOG_DIR, "*_trades.csv"))
-    pairs = []
-    for f in files:
-        base = os.path.basename(f)
-        sess = base.split("_")[0]
-        if sess.isdigit():
-            pairs.append((int(sess), sess))
-    if not pairs:
-        return None
-    pairs.sort(reverse=True)
-    return pairs[0][1]
+    sessions = journal.list_sessions(LOG_DIR)
+    return str(sessions[0]) if sessions else None
 
 def load_trades(session):
-    path = os.path.join(LOG_DIR, f"{session}_trades.csv")
-    rows = []
-    if not os.path.exists(path):
-        return rows
-    with open(path, newline="") as fp:
-        r = csv.DictReader(fp)
-        for row in r:
-            try:
-                qty = int(row["qty"])
-                px  = float(row["px"])
-                maker_client = row["maker_client"]
-                taker_client = row["taker_client"]
-                maker_side = row["maker_side"]
-                taker_side = row["taker_side"]
-                rows.append((maker_client, taker_client, maker_side, taker_side, qty, px))
-            except Exception:
-                pass
-    return rows
+    # binary journal when present (mapped, no parsing); CSV for older sessions
+    return journal.load_rows(session, LOG_DIR, names=["maker_client", "taker_client",
+                                                      "maker_side", "taker_side", "qty", "px"])
 
 def load_last_mid(session):
     path = os.path.join(LOG_DIR, f"{session}_book.csv")
@@ -42,6 +42,14 @@ class LineClient:
         self.send_line(line)
         return self.read_line()
 
+    def request_lines(self, line: str):
+        # replies of the form "<TAG> <n> ..." followed by n lines (LEADERBOARD, STATS, BATCH)
+        head = self.request_reply(line)
+        parts = head.split()
+        if len(parts) < 2 or not parts[1].isdigit():
+            raise RuntimeError(head)
+        return head, [self.read_line() for _ in range(int(parts[1]))]
+
     def close(self):
         if self.sock:
             try:
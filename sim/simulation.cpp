@@ -0,0 +1,81 @@
+#include "sim/simulation.hpp"
+#include "engine/matching_engine.hpp"
+#include "engine/position_book.hpp"
+#include "strategy/engine_host.hpp"
+#include "strategy/market_maker.hpp"
+#include "strategy/noise_trader.hpp"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace ts {
+
+RunResult run_simulation(const SimConfig& cfg, uint64_t seed, SlabCache* slabs) {
+  RunResult r;
+  r.seed = seed;
+  std::mt19937_64 rng(seed);
+
+  MatchingEngine engine(cfg.tick, 4096, PoolConfig{cfg.order_capacity, false, slabs});
+  PositionBook positions;
+  Price last_px = 0;
+  EngineHost host(engine);
+  host.set_trade_listener([&](const Trade& t) {
+    positions.on_fill(t);
+    r.volume += static_cast<uint64_t>(t.qty);
+    r.low = r.trades ? std::min(r.low, t.px) : t.px;
+    r.high = std::max(r.high, t.px);
+    ++r.trades;
+    last_px = t.px;
+  });
+
+  // the same strategies bot_mm and bot_random run over TCP
+  std::vector<std::unique_ptr<Strategy>> bots;
+  std::uniform_int_distribution<int> half(1, std::max(cfg.max_half_spread, 1));
+  for (size_t i = 0; i < cfg.market_makers + cfg.noise_traders; ++i) {
+    if (i < cfg.market_makers)
+      bots.push_back(std::make_unique<MarketMaker>(cfg.mm_qty, half(rng), cfg.start_px));
+    else
+      bots.push_back(std::make_unique<NoiseTrader>(rng(), cfg.trade_prob, cfg.noise_max_qty));
+    host.add(*bots.back(), static_cast<ClientId>(i + 1));
+  }
+  if (bots.empty()) return r;
+
+  host.start();
+  std::uniform_int_distribution<size_t> pick(0, bots.size() - 1);
+  uint64_t two_sided = 0;
+  int64_t spread_sum = 0;
+  for (size_t step = 0; step < cfg.steps; ++step) {
+    host.timer(pick(rng));
+    TopOfBook t = engine.top();
+    if (t.has_bid && t.has_ask) {
+      ++two_sided;
+      spread_sum += t.ask_px - t.bid_px;
+      r.max_spread = std::max(r.max_spread, t.ask_px - t.bid_px);
+    }
+  }
+  r.orders = host.orders();
+
+  // marked before on_stop: the makers pull their quotes there
+  TopOfBook t = engine.top();
+  const PriceScale& sc = engine.scale();
+  double mark = static_cast<double>(last_px ? last_px : cfg.start_px);
+  if (t.has_bid && t.has_ask) mark = static_cast<double>(t.bid_px + t.ask_px) / 2.0;
+  host.stop();
+  r.final_mid = mark / sc.ticks_per_unit;
+  r.mean_spread = two_sided ? static_cast<double>(spread_sum) / static_cast<double>(two_sided) : 0.0;
+  r.two_sided = cfg.steps ? static_cast<double>(two_sided) / static_cast<double>(cfg.steps) : 0.0;
+
+  r.best_pnl = -1e300;
+  r.worst_pnl = 1e300;
+  for (size_t i = 0; i < bots.size(); ++i) {
+    const Position* p = positions.find(static_cast<ClientId>(i + 1));
+    double pnl = p ? p->pnl(mark) / sc.ticks_per_unit : 0.0;
+    (i < cfg.market_makers ? r.mm_pnl : r.noise_pnl) += pnl;
+    r.best_pnl = std::max(r.best_pnl, pnl);
+    r.worst_pnl = std::min(r.worst_pnl, pnl);
+  }
+  return r;
+}
+
+} // namespace ts
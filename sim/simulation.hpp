@@ -0,0 +1,46 @@
+#pragma once
+#include "common/types.hpp"
+#include "engine/pool.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace ts {
+
+// One bot population on one instrument, run in-process against a private
+// MatchingEngine: no server, sockets or sleeps. Prices are ticks.
+struct SimConfig {
+  size_t steps{20000};        // bot turns per run; each turn one bot, drawn at random, acts
+  size_t market_makers{4};    // quote both sides around the mid (MarketMaker, like bot_mm)
+  size_t noise_traders{16};   // send market orders of random side and size (NoiseTrader, like bot_random)
+  double tick{0.01};
+  Price start_px{1000};       // mid assumed while the book is empty
+  int mm_qty{5};              // per quote
+  int max_half_spread{5};     // each maker quotes mid +/- a half spread drawn from [1, this]
+  double trade_prob{0.3};     // chance a noise trader's turn sends an order
+  int noise_max_qty{5};       // noise order size drawn from [1, this]
+  size_t order_capacity{1 << 12};  // engine node pool slab
+};
+
+struct RunResult {
+  uint64_t seed{0};
+  uint64_t orders{0};    // new orders and replaces sent
+  uint64_t trades{0};
+  uint64_t volume{0};
+  double final_mid{0};   // price units; last trade price if a side is empty
+  double mean_spread{0}; // ticks, over turns that ended with both sides quoted
+  Price max_spread{0};
+  double two_sided{0};   // fraction of turns that ended with both sides quoted
+  Price low{0}, high{0}; // trade price range (0 without trades)
+  // price units, marked to final_mid
+  double mm_pnl{0};      // all market makers together
+  double noise_pnl{0};   // all noise traders together
+  double best_pnl{0}, worst_pnl{0};  // single bots
+};
+
+// One independent run: a fresh engine and bot population, everything drawn
+// from seed, so the same config and seed give the same result on any
+// thread. slabs: the calling thread's cache for the engine's order pool
+// (nullptr: straight from the OS).
+RunResult run_simulation(const SimConfig& cfg, uint64_t seed, SlabCache* slabs);
+
+} // namespace ts
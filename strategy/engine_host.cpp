@@ -0,0 +1,126 @@
+#include "strategy/engine_host.hpp"
+
+namespace ts {
+
+static bool same_top(const TopOfBook& a, const TopOfBook& b) {
+  return a.has_bid == b.has_bid && a.has_ask == b.has_ask && a.bid_px == b.bid_px && a.ask_px == b.ask_px &&
+         a.bid_qty == b.bid_qty && a.ask_qty == b.ask_qty;
+}
+
+// One strategy's view: its actions carry its client id.
+struct EngineHost::Slot : StrategyContext {
+  Slot(EngineHost& h, Strategy& s, ClientId c) : host(h), strategy(s), client(c) {}
+
+  EngineHost& host;
+  Strategy& strategy;
+  ClientId client;
+
+  uint64_t limit(Side side, int qty, Price px) override {
+    MatchingEngine& e = host.engine_;
+    ++host.orders_;
+    uint64_t id = e.next_order_id();
+    if (!e.new_limit_order(client, side, qty, e.scale().to_px(px), host.fills_)) return 0;
+    host.absorb(host.fills_);
+    return id;
+  }
+  void market(Side side, int qty) override {
+    ++host.orders_;
+    if (!host.engine_.new_market_order(client, side, qty, host.fills_)) return;
+    host.absorb(host.fills_);
+  }
+  bool replace(uint64_t id, int qty, Price px) override {
+    MatchingEngine& e = host.engine_;
+    ++host.orders_;
+    ReplaceResult r = e.replace(id, qty, e.scale().to_px(px), host.fills_);
+    host.absorb(host.fills_);
+    return r == ReplaceResult::Amended || r == ReplaceResult::Requeued;
+  }
+  bool cancel(uint64_t id) override {
+    // the engine does not check ownership; a strategy only knows its own ids
+    bool ok = host.engine_.cancel(id);
+    host.fills_.clear();
+    host.absorb(host.fills_);
+    return ok;
+  }
+  void cancel_all() override {
+    (void)host.engine_.cancel_all(client);
+    host.fills_.clear();
+    host.absorb(host.fills_);
+  }
+
+  TopOfBook top() const override { return host.engine_.top(); }
+  const PriceScale& scale() const override { return host.engine_.scale(); }
+};
+
+EngineHost::EngineHost(MatchingEngine& engine) : engine_(engine), last_top_(engine.top()) {}
+
+EngineHost::~EngineHost() = default;
+
+size_t EngineHost::add(Strategy& s, ClientId client) {
+  slots_.push_back(std::make_unique<Slot>(*this, s, client));
+  if (client >= by_client_.size()) by_client_.resize(static_cast<size_t>(client) + 1, 0);
+  by_client_[client] = slots_.size();
+  return slots_.size() - 1;
+}
+
+void EngineHost::start() {
+  for (auto& s : slots_) {
+    s->strategy.on_start(*s);
+    drain();
+  }
+}
+
+void EngineHost::timer(size_t i) {
+  Slot& s = *slots_[i];
+  s.strategy.on_timer(s);
+  drain();
+}
+
+void EngineHost::stop() {
+  for (auto& s : slots_) {
+    s->strategy.on_stop(*s);
+    drain();
+  }
+}
+
+void EngineHost::on_external(const std::vector<Trade>& fills) {
+  absorb(fills);
+  drain();
+}
+
+void EngineHost::absorb(const std::vector<Trade>& fills) {
+  for (const Trade& t : fills) {
+    if (listener_) listener_(t);
+    events_.push_back(Event{true, t, {}});
+  }
+  TopOfBook now = engine_.top();
+  if (!same_top(now, last_top_)) {
+    last_top_ = now;
+    events_.push_back(Event{false, {}, now});
+  }
+}
+
+// Delivery may act and so queue more events: loop until none are left.
+void EngineHost::drain() {
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event ev = events_[i];  // copy: callbacks may grow events_
+    if (!ev.trade) {
+      for (auto& s : slots_) s->strategy.on_book(ev.top, *s);
+      continue;
+    }
+    const Trade& t = ev.t;
+    auto owner = [&](ClientId c) { return c < by_client_.size() ? by_client_[c] : 0; };
+    if (size_t m = owner(t.maker_client)) {
+      Slot& s = *slots_[m - 1];
+      s.strategy.on_fill(FillEvent{t.maker_id, t.maker_side, t.qty, t.px}, s);
+    }
+    if (size_t k = owner(t.taker_client)) {
+      Slot& s = *slots_[k - 1];
+      s.strategy.on_fill(FillEvent{t.taker_id, t.taker_side, t.qty, t.px}, s);
+    }
+    for (auto& s : slots_) s->strategy.on_trade(TradeEvent{t.px, t.qty, t.taker_side}, *s);
+  }
+  events_.clear();
+}
+
+} // namespace ts
@@ -0,0 +1,60 @@
+#pragma once
+#include "engine/matching_engine.hpp"
+#include "strategy/strategy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ts {
+
+// Hosts strategies in-process on one MatchingEngine, on the thread that
+// owns it. Actions are direct engine calls; every fill they cause goes to
+// the owning strategies as on_fill, then to all as on_trade, and a changed
+// top of book as on_book. Events are queued while a callback runs and
+// delivered when it returns, so strategies never see re-entrant calls.
+class EngineHost {
+public:
+  explicit EngineHost(MatchingEngine& engine);
+  ~EngineHost();
+
+  EngineHost(const EngineHost&) = delete;
+  EngineHost& operator=(const EngineHost&) = delete;
+
+  // s trades as client (unique per strategy); returns its index for timer()
+  size_t add(Strategy& s, ClientId client);
+  // every trade from a hosted action, before the strategies hear of it
+  void set_trade_listener(std::function<void(const Trade&)> f) { listener_ = std::move(f); }
+
+  void start();          // on_start for each strategy, in order added
+  void timer(size_t i);  // strategy i's turn
+  void stop();           // on_stop for each strategy
+  // fills of orders that did not come through the host (e.g. other
+  // clients on the same engine), so hosted strategies see them too
+  void on_external(const std::vector<Trade>& fills);
+
+  uint64_t orders() const { return orders_; }  // limit, market and replace actions
+
+private:
+  struct Slot;
+  struct Event {
+    bool trade;  // else a book change
+    Trade t;
+    TopOfBook top;
+  };
+
+  MatchingEngine& engine_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<size_t> by_client_;  // ClientId -> slot index + 1 (0: not hosted)
+  std::function<void(const Trade&)> listener_;
+  std::vector<Trade> fills_;  // reused sink for every action
+  std::vector<Event> events_;
+  TopOfBook last_top_;
+  uint64_t orders_{0};
+
+  void absorb(const std::vector<Trade>& fills);  // queue the events of one engine call
+  void drain();
+};
+
+} // namespace ts
@@ -0,0 +1,49 @@
+#include "strategy/market_maker.hpp"
+#include <algorithm>
+
+namespace ts {
+
+void MarketMaker::on_timer(StrategyContext& ctx) {
+  // in half ticks: a mid between two ticks widens both quotes evenly
+  // instead of rounding one way, which would drift the price
+  TopOfBook t = ctx.top();
+  Price mid2 = 2 * last_px_;
+  if (t.has_bid && t.has_ask) mid2 = t.bid_px + t.ask_px;
+  else if (t.has_bid) mid2 = 2 * (t.bid_px + half_spread_);
+  else if (t.has_ask) mid2 = 2 * (t.ask_px - half_spread_);
+  const Price px[2] = {std::max<Price>((mid2 - 2 * half_spread_) / 2, 1), (mid2 + 2 * half_spread_ + 1) / 2};
+  uint64_t* ids[2] = {&bid_id_, &ask_id_};
+  const Side sides[2] = {Side::Buy, Side::Sell};
+
+  // both sides in one execute (one BATCH remotely); a quote that is gone
+  // comes back 0 and is placed anew in a second one
+  for (int pass = 0; pass < 2; ++pass) {
+    actions_.clear();
+    for (int s = 0; s < 2; ++s) {
+      if (pass == 1 && *ids[s]) continue;
+      Action a;
+      a.kind = *ids[s] ? Action::Kind::Replace : Action::Kind::Limit;
+      a.side = sides[s];
+      a.qty = qty_;
+      a.px = px[s];
+      a.id = *ids[s];
+      actions_.push_back(a);
+    }
+    if (actions_.empty()) return;
+    ctx.execute(actions_);
+    bool missing = false;
+    for (const Action& a : actions_) {
+      uint64_t& id = a.side == Side::Buy ? bid_id_ : ask_id_;
+      id = a.result;
+      missing |= a.kind == Action::Kind::Replace && a.result == 0;
+    }
+    if (!missing) return;
+  }
+}
+
+void MarketMaker::on_stop(StrategyContext& ctx) {
+  ctx.cancel_all();
+  bid_id_ = ask_id_ = 0;
+}
+
+} // namespace ts
@@ -0,0 +1,36 @@
+#pragma once
+#include "strategy/strategy.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace ts {
+
+// Quotes qty on both sides at mid +/- half_spread ticks every turn, moving
+// the resting quotes with REPLACE (queue position kept when unchanged) and
+// placing a quote afresh once it was filled. The mid is the book's; with
+// one side empty it is that side's price plus/minus half_spread, with both
+// empty the last trade (else start_mid). Pulls everything on stop.
+class MarketMaker : public Strategy {
+public:
+  MarketMaker(int qty, Price half_spread, Price start_mid)
+      : qty_(qty), half_spread_(half_spread), last_px_(start_mid) {}
+
+  void on_timer(StrategyContext& ctx) override;
+  void on_trade(const TradeEvent& t, StrategyContext&) override { last_px_ = t.px; }
+  void on_fill(const FillEvent& f, StrategyContext&) override {
+    position_ += f.side == Side::Buy ? f.qty : -f.qty;
+  }
+  void on_stop(StrategyContext& ctx) override;
+
+  int64_t position() const { return position_; }  // net shares bought, from fills
+
+private:
+  int qty_;
+  Price half_spread_;
+  Price last_px_;
+  uint64_t bid_id_{0}, ask_id_{0};
+  int64_t position_{0};
+  std::vector<Action> actions_;  // reused
+};
+
+} // namespace ts
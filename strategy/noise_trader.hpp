@@ -0,0 +1,28 @@
+#pragma once
+#include "strategy/strategy.hpp"
+#include <cstdint>
+#include <random>
+
+namespace ts {
+
+// Each turn, with probability trade_prob, a market order of random side
+// and a size drawn from [1, max_qty]. Everything comes from seed.
+class NoiseTrader : public Strategy {
+public:
+  NoiseTrader(uint64_t seed, double trade_prob, int max_qty)
+      : rng_(seed), trade_(trade_prob), qty_(1, max_qty > 1 ? max_qty : 1) {}
+
+  void on_timer(StrategyContext& ctx) override {
+    if (!trade_(rng_)) return;
+    Side side = buy_(rng_) ? Side::Buy : Side::Sell;
+    ctx.market(side, qty_(rng_));
+  }
+
+private:
+  std::mt19937_64 rng_;
+  std::bernoulli_distribution trade_;
+  std::bernoulli_distribution buy_{0.5};
+  std::uniform_int_distribution<int> qty_;
+};
+
+} // namespace ts
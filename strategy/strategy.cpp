@@ -0,0 +1,16 @@
+#include "strategy/strategy.hpp"
+
+namespace ts {
+
+void StrategyContext::execute(std::vector<Action>& actions) {
+  for (Action& a : actions) {
+    switch (a.kind) {
+      case Action::Kind::Limit: a.result = limit(a.side, a.qty, a.px); break;
+      case Action::Kind::Market: market(a.side, a.qty); a.result = 0; break;
+      case Action::Kind::Replace: a.result = replace(a.id, a.qty, a.px) ? a.id : 0; break;
+      case Action::Kind::Cancel: a.result = cancel(a.id) ? 1 : 0; break;
+    }
+  }
+}
+
+} // namespace ts
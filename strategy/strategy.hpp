@@ -0,0 +1,78 @@
+#pragma once
+#include "common/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ts {
+
+// Strategy plugin API: a bot written once against these types runs either
+// in-process next to a MatchingEngine (EngineHost: direct engine calls, no
+// text or sockets) or against a server over TCP (TcpHost). Prices are
+// ticks of the instrument; StrategyContext::scale() converts.
+
+// A trade on the strategy's instrument, whoever traded.
+struct TradeEvent {
+  Price px{0};
+  int qty{0};
+  Side taker_side{Side::Buy};
+};
+
+// One of the strategy's own orders traded (side: that order's).
+struct FillEvent {
+  uint64_t order_id{0};
+  Side side{Side::Buy};
+  int qty{0};
+  Price px{0};
+};
+
+// One order action for StrategyContext::execute. result is what the single
+// call returns: the order id for Limit, the id or 0 (no longer resting) for
+// Replace, 1/0 for Cancel, 0 for Market.
+struct Action {
+  enum class Kind : uint8_t { Limit, Market, Replace, Cancel };
+  Kind kind{Kind::Limit};
+  Side side{Side::Buy};
+  int qty{0};
+  Price px{0};
+  uint64_t id{0};  // Replace / Cancel target
+  uint64_t result{0};
+};
+
+// What a strategy can see and do; implemented by each host. Actions run
+// at once; the fills, trades and book changes they cause reach the
+// strategy as events after the current callback returns.
+class StrategyContext {
+public:
+  virtual ~StrategyContext() = default;
+
+  // order id, or 0 if rejected
+  virtual uint64_t limit(Side side, int qty, Price px) = 0;
+  virtual void market(Side side, int qty) = 0;
+  // new open qty and price for a resting order, keeping its id; false if
+  // it no longer rests (filled or cancelled)
+  virtual bool replace(uint64_t id, int qty, Price px) = 0;
+  virtual bool cancel(uint64_t id) = 0;
+  virtual void cancel_all() = 0;  // every resting order of this strategy
+
+  // several actions in order; a remote host sends them as one BATCH
+  virtual void execute(std::vector<Action>& actions);
+
+  virtual TopOfBook top() const = 0;  // empty sides if the host has no book feed
+  virtual const PriceScale& scale() const = 0;
+};
+
+// Callbacks arrive one at a time on the host's thread.
+class Strategy {
+public:
+  virtual ~Strategy() = default;
+
+  virtual void on_start(StrategyContext&) {}
+  virtual void on_timer(StrategyContext&) {}  // the strategy's turn (host clock or simulation step)
+  virtual void on_book(const TopOfBook&, StrategyContext&) {}  // top of book changed
+  virtual void on_trade(const TradeEvent&, StrategyContext&) {}
+  virtual void on_fill(const FillEvent&, StrategyContext&) {}
+  virtual void on_stop(StrategyContext&) {}  // last chance to act, e.g. pull quotes
+};
+
+} // namespace ts
@@ -0,0 +1,207 @@
+#include "strategy/tcp_host.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace ts {
+
+// Order id from an entry reply: "OK <id>", "AMENDED <id>", "REPLACED <id>";
+// 0 when the order is gone (NOT FOUND) or was rejected.
+static uint64_t order_id(const std::string& reply) {
+  if (reply.rfind("OK ", 0) != 0 && reply.rfind("AMENDED ", 0) != 0 && reply.rfind("REPLACED ", 0) != 0) return 0;
+  return std::strtoull(reply.c_str() + reply.rfind(' ') + 1, nullptr, 10);
+}
+
+static bool same_top(const TopOfBook& a, const TopOfBook& b) {
+  return a.has_bid == b.has_bid && a.has_ask == b.has_ask && a.bid_px == b.bid_px && a.ask_px == b.ask_px &&
+         a.bid_qty == b.bid_qty && a.ask_qty == b.ask_qty;
+}
+
+TcpHost::TcpHost(TcpHostConfig cfg) : cfg_(std::move(cfg)), scale_(cfg_.tick) {
+  if (!cfg_.symbol.empty()) sym_ = " SYMBOL " + cfg_.symbol;
+}
+
+bool TcpHost::connect(std::string& err) {
+  if (!c_.connect(cfg_.host, cfg_.port)) { err = "connect failed"; return false; }
+  std::string line;
+  c_.read_line(line);  // greeting
+
+  if (cfg_.book_feed) {
+    c_.send_line("SUBSCRIBE BOOK" + sym_);
+    while (c_.read_line(line) && !book_.apply(line)) {
+      if (line.rfind("ERROR", 0) == 0) break;
+    }
+    if (!book_.ready()) { err = "subscribe failed: " + line; return false; }
+  }
+  if (cfg_.trade_feed && !subscribe("TRADES", err)) return false;
+  if (cfg_.fills && !subscribe("FILLS CLIENT " + cfg_.client, err)) return false;
+  last_top_ = top();
+  return true;
+}
+
+bool TcpHost::subscribe(const std::string& what, std::string& err) {
+  std::string reply;
+  if (request("SUBSCRIBE " + what + sym_, reply) && reply.rfind("SUBSCRIBED", 0) == 0) return true;
+  err = "subscribe failed: " + reply;
+  return false;
+}
+
+bool TcpHost::feed(const std::string& line) {
+  if (book_.apply(line)) return true;
+  if (line.rfind("MD ", 0) != 0) return false;
+  // MD TRADE <sym> <seq> <qty>@<px> <BUY|SELL>
+  // MD FILL <sym> <seq> <order id> <qty>@<px> <BUY|SELL>
+  std::istringstream iss(line);
+  std::string md, kind, sym, fill, side;
+  uint64_t seq = 0, id = 0;
+  if (!(iss >> md >> kind >> sym >> seq) || (kind != "TRADE" && kind != "FILL")) return true;
+  if ((kind == "FILL" && !(iss >> id)) || !(iss >> fill >> side)) return true;
+  auto at = fill.find('@');
+  if (at == std::string::npos) return true;
+  int qty = std::atoi(fill.c_str());
+  Price px = scale_.to_ticks(std::strtod(fill.c_str() + at + 1, nullptr));
+  Side s = side == "BUY" ? Side::Buy : Side::Sell;
+  if (kind == "FILL") fills_.push_back(FillEvent{id, s, qty, px});
+  else trades_.push_back(TradeEvent{px, qty, s});
+  return true;  // other MD lines (TRADES_GAP) carry nothing a strategy needs
+}
+
+bool TcpHost::request(const std::string& cmd, std::string& reply) {
+  if (!c_.send_line(cmd)) return false;
+  while (c_.read_line(reply)) {
+    if (!feed(reply)) return true;
+  }
+  return false;
+}
+
+TopOfBook TcpHost::top() const {
+  TopOfBook t;
+  double px = 0;
+  int64_t qty = 0;
+  if ((t.has_bid = book_.best_bid(px, qty))) {
+    t.bid_px = scale_.to_ticks(px);
+    t.bid_qty = static_cast<int>(qty);
+  }
+  if ((t.has_ask = book_.best_ask(px, qty))) {
+    t.ask_px = scale_.to_ticks(px);
+    t.ask_qty = static_cast<int>(qty);
+  }
+  return t;
+}
+
+// Everything the feeds brought since the last delivery, fills first as
+// EngineHost does. Callbacks may act, and what that brings in is delivered
+// in the next round.
+void TcpHost::deliver(Strategy& s) {
+  for (int round = 0; round < 16; ++round) {
+    std::vector<FillEvent> fills;
+    fills.swap(fills_);
+    for (const FillEvent& f : fills) s.on_fill(f, *this);
+    std::vector<TradeEvent> trades;
+    trades.swap(trades_);
+    for (const TradeEvent& t : trades) s.on_trade(t, *this);
+    bool any = !fills.empty() || !trades.empty();
+    TopOfBook now = top();
+    if (!same_top(now, last_top_)) {
+      last_top_ = now;
+      s.on_book(now, *this);
+      any = true;
+    }
+    if (!any) return;
+  }
+}
+
+void TcpHost::run(Strategy& s, int turns, int interval_ms) {
+  s.on_start(*this);
+  deliver(s);
+  std::string line;
+  for (int i = 0; i < turns; ++i) {
+    s.on_timer(*this);
+    deliver(s);
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval_ms);
+    for (auto now = std::chrono::steady_clock::now(); now < until; now = std::chrono::steady_clock::now()) {
+      int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count());
+      int r = c_.try_read_line(line, ms);
+      if (r < 0) return;
+      if (r == 0) break;
+      feed(line);
+      deliver(s);
+    }
+  }
+  s.on_stop(*this);
+  // the server answers what is in flight, then closes: late fills still count
+  c_.send_line("QUIT");
+  while (c_.read_line(line)) feed(line);
+  deliver(s);
+}
+
+std::string TcpHost::order_line(const Action& a) const {
+  char px[32];
+  std::snprintf(px, sizeof(px), "%.10g", scale_.to_px(a.px));
+  const char* side = a.side == Side::Buy ? "BUY" : "SELL";
+  switch (a.kind) {
+    case Action::Kind::Limit:
+      return std::string("NEW LIMIT ") + side + " " + std::to_string(a.qty) + " @ " + px + " CLIENT " + cfg_.client;
+    case Action::Kind::Market:
+      return std::string("NEW MARKET ") + side + " " + std::to_string(a.qty) + " CLIENT " + cfg_.client;
+    case Action::Kind::Replace:
+      return "REPLACE " + std::to_string(a.id) + " " + std::to_string(a.qty) + " @ " + px;
+    case Action::Kind::Cancel:
+      return "CANCEL " + std::to_string(a.id);
+  }
+  return {};
+}
+
+static uint64_t result_of(const Action& a, const std::string& reply) {
+  if (a.kind == Action::Kind::Cancel) return reply.rfind("CANCELLED ", 0) == 0 ? 1 : 0;
+  if (a.kind == Action::Kind::Market) return 0;
+  return order_id(reply);
+}
+
+uint64_t TcpHost::limit(Side side, int qty, Price px) {
+  std::vector<Action> one{Action{Action::Kind::Limit, side, qty, px, 0, 0}};
+  execute(one);
+  return one[0].result;
+}
+
+void TcpHost::market(Side side, int qty) {
+  std::vector<Action> one{Action{Action::Kind::Market, side, qty, 0, 0, 0}};
+  execute(one);
+}
+
+bool TcpHost::replace(uint64_t id, int qty, Price px) {
+  std::vector<Action> one{Action{Action::Kind::Replace, Side::Buy, qty, px, id, 0}};
+  execute(one);
+  return one[0].result != 0;
+}
+
+bool TcpHost::cancel(uint64_t id) {
+  std::vector<Action> one{Action{Action::Kind::Cancel, Side::Buy, 0, 0, id, 0}};
+  execute(one);
+  return one[0].result != 0;
+}
+
+void TcpHost::cancel_all() {
+  std::string reply;
+  request("CANCEL ALL CLIENT " + cfg_.client + sym_, reply);
+}
+
+// One action is one command; several are one BATCH, answered "BATCH <n>"
+// plus a line per action.
+void TcpHost::execute(std::vector<Action>& actions) {
+  std::string reply;
+  if (actions.size() == 1) {
+    actions[0].result = request(order_line(actions[0]) + sym_, reply) ? result_of(actions[0], reply) : 0;
+    return;
+  }
+  std::string cmd = "BATCH " + std::to_string(actions.size()) + sym_;
+  for (const Action& a : actions) cmd += "\n" + order_line(a);
+  bool ok = request(cmd, reply) && reply.rfind("BATCH", 0) == 0;
+  for (Action& a : actions) {
+    a.result = 0;
+    if (ok && c_.read_line(reply)) a.result = result_of(a, reply);
+  }
+}
+
+} // namespace ts
@@ -0,0 +1,62 @@
+#pragma once
+#include "net/book_mirror.hpp"
+#include "net/client.hpp"
+#include "strategy/strategy.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+struct TcpHostConfig {
+  std::string host{"127.0.0.1"};
+  int port{5555};
+  std::string client;     // name the orders are sent under
+  std::string symbol;     // "" = the server's default symbol
+  double tick{0.01};      // the symbol's tick, for ticks <-> price text
+  bool book_feed{true};   // SUBSCRIBE BOOK: top() and on_book
+  bool trade_feed{true};  // SUBSCRIBE TRADES: on_trade
+  bool fills{true};       // SUBSCRIBE FILLS CLIENT <client>: on_fill
+};
+
+// Runs a Strategy against a server over the text protocol, so a class
+// written for EngineHost also works remotely. Feeds become on_book,
+// on_trade and on_fill (MD FILL, per order); actions become commands
+// answered in order (execute() sends one BATCH).
+class TcpHost : public StrategyContext {
+public:
+  explicit TcpHost(TcpHostConfig cfg);
+
+  bool connect(std::string& err);  // connect and subscribe
+  // on_start; turns x (on_timer, then interval_ms of feed events); on_stop
+  void run(Strategy& s, int turns, int interval_ms);
+
+  uint64_t limit(Side side, int qty, Price px) override;
+  void market(Side side, int qty) override;
+  bool replace(uint64_t id, int qty, Price px) override;
+  bool cancel(uint64_t id) override;
+  void cancel_all() override;
+  void execute(std::vector<Action>& actions) override;
+
+  TopOfBook top() const override;
+  const PriceScale& scale() const override { return scale_; }
+
+private:
+  TcpHostConfig cfg_;
+  PriceScale scale_;
+  std::string sym_;  // " SYMBOL <name>" or ""
+  Client c_;
+  BookMirror book_;
+  TopOfBook last_top_;
+  std::vector<TradeEvent> trades_;  // from the feed, not yet delivered
+  std::vector<FillEvent> fills_;
+
+  // send cmd and read its reply line, applying feed lines that come first
+  bool request(const std::string& cmd, std::string& reply);
+  bool feed(const std::string& line);  // true if the line was feed data
+  bool subscribe(const std::string& what, std::string& err);
+  void deliver(Strategy& s);
+  std::string order_line(const Action& a) const;
+};
+
+} // namespace ts
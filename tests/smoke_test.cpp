@@ -1,34 +1,582 @@
+#include "common/client_table.hpp"
+#include "common/input_journal.hpp"
+#include "common/latency_histogram.hpp"
+#include "common/mpsc_ring.hpp"
+#include "common/trade_journal.hpp"
+#include "common/work_pool.hpp"
 #include "engine/matching_engine.hpp"
+#include "engine/position_book.hpp"
+#include "net/bar_series.hpp"
+#include "net/event_loop.hpp"
+#include "net/metrics.hpp"
+#include "net/trade_ring.hpp"
+#include "sim/simulation.hpp"
+#include "strategy/engine_host.hpp"
+#include "strategy/market_maker.hpp"
+#include <atomic>
 #include <cassert>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 using namespace ts;
 
+// rests 5 @ 10.00 on start (maker) or buys 2 at market each turn (taker)
+struct Recorder : Strategy {
+  bool maker;
+  uint64_t id{0};
+  int books{0}, trades{0};
+  std::vector<FillEvent> fills;
+  explicit Recorder(bool m) : maker(m) {}
+  void on_start(StrategyContext& ctx) override {
+    if (maker) id = ctx.limit(Side::Sell, 5, 1000);
+  }
+  void on_timer(StrategyContext& ctx) override {
+    if (!maker) ctx.market(Side::Buy, 2);
+  }
+  void on_book(const TopOfBook&, StrategyContext&) override { ++books; }
+  void on_trade(const TradeEvent& t, StrategyContext&) override { trades += t.qty == 2 && t.px == 1000; }
+  void on_fill(const FillEvent& f, StrategyContext&) override { fills.push_back(f); }
+};
+
+// heap allocations so far, for the zero-allocation matching check
+static size_t g_allocs = 0;
+void* operator new(size_t n) {
+  ++g_allocs;
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 int main() {
+  // Client names are interned once; the engine only sees the ids
+  ClientTable names;
+  ClientId alice = names.intern("alice");
+  assert(alice != ClientTable::kNone && names.intern("alice") == alice);
+  assert(names.intern("bob") != alice && names.name(alice) == "alice");
+  assert(names.intern("") == ClientTable::kNone && names.name(ClientTable::kNone).empty());
+
   MatchingEngine eng;
 
   // Resting asks
-  eng.new_limit_order("asker1", Side::Sell, 50, 10.20);
-  eng.new_limit_order("asker2", Side::Sell, 50, 10.25);
+  eng.new_limit_order(names.intern("asker1"), Side::Sell, 50, 10.20);
+  eng.new_limit_order(names.intern("asker2"), Side::Sell, 50, 10.25);
 
   // Market buy 80 -> 50 @10.20 + 30 @10.25
-  auto t1 = eng.new_market_order("buyer1", Side::Buy, 80);
+  auto t1 = eng.new_market_order(names.intern("buyer1"), Side::Buy, 80);
   int qty_sum = 0; for (auto& t : t1) qty_sum += t.qty;
   assert(qty_sum == 80);
   assert(t1.size() == 2);
+  assert(names.name(t1[0].maker_client) == "asker1" && names.name(t1[1].taker_client) == "buyer1");
 
   // Top should be ask 20 @ 10.25
   auto top = eng.top();
-  assert(top.has_ask && top.ask_px == 10.25 && top.ask_qty == 20);
+  assert(top.has_ask && eng.scale().to_px(top.ask_px) == 10.25 && top.ask_qty == 20);
 
   // Add bid, then a crossing sell
-  eng.new_limit_order("bidder", Side::Buy, 100, 10.30);
-  auto t2 = eng.new_limit_order("seller", Side::Sell, 25, 10.00);
+  eng.new_limit_order(names.intern("bidder"), Side::Buy, 100, 10.30);
+  auto t2 = eng.new_limit_order(names.intern("seller"), Side::Sell, 25, 10.00);
   qty_sum = 0; for (auto& t : t2) qty_sum += t.qty;
   assert(qty_sum == 25);
 
   auto top2 = eng.top();
-  assert(top2.has_bid && top2.bid_px == 10.30);
+  assert(top2.has_bid && eng.scale().to_px(top2.bid_px) == 10.30 && top2.bid_qty == 55);
+  assert(!top2.has_ask); // fully filled orders must not rest
+
+  // Prices are integer ticks: 10.05 and 10.0499999999 (float noise) land on
+  // the same level
+  MatchingEngine tick_eng(0.01, /*ladder_window*/ 64);
+  tick_eng.new_limit_order(names.intern("a"), Side::Buy, 1, 10.05);
+  tick_eng.new_limit_order(names.intern("b"), Side::Buy, 2, 10.0499999999);
+  assert(tick_eng.top().bid_qty == 3);
+
+  // Levels far outside the ladder window still match in price order
+  tick_eng.new_limit_order(names.intern("c"), Side::Buy, 4, 2.00);
+  tick_eng.new_limit_order(names.intern("d"), Side::Buy, 5, 50.00);
+  assert(tick_eng.top().bid_px == tick_eng.scale().to_ticks(50.00));
+  auto sweep = tick_eng.new_market_order(names.intern("e"), Side::Sell, 9);
+  assert(sweep.size() == 4 && sweep[0].px == tick_eng.scale().to_ticks(50.00));
+  assert(tick_eng.top().bid_px == tick_eng.scale().to_ticks(2.00) && tick_eng.top().bid_qty == 3);
+  assert(tick_eng.cancel(3) && !tick_eng.top().has_bid); // order "c"
+  assert(!tick_eng.cancel(3));
+
+  // The ladder window follows the best price even while a stale order sits
+  // at the old one: drift bids up three windows, one live level at a time
+  {
+    PriceLadder bids(Side::Buy, 64);
+    std::vector<OrderNode> nodes(200);
+    nodes[0].px = 1000;  // stale, never cancelled
+    nodes[0].qty = 1;
+    bids.push_back(&nodes[0]);
+    for (size_t i = 1; i < nodes.size(); ++i) {
+      nodes[i].px = 1000 + static_cast<Price>(i);
+      nodes[i].qty = 1;
+      bids.push_back(&nodes[i]);
+      if (i > 1) bids.remove(&nodes[i - 1]);
+      assert(bids.best_px() == nodes[i].px && bids.best_in_window() && bids.levels() == 2);
+    }
+    assert(bids.far_levels() == 1 && bids.find(1000) && bids.find(1000)->orders == 1);
+    bids.remove(&nodes.back());  // back down to the stale level: the window goes with it
+    assert(bids.best_px() == 1000 && bids.best_in_window() && bids.far_levels() == 0);
+    std::vector<Price> seen;
+    bids.push_back(&nodes[1]);   // 1001 again, inside the window
+    bids.visit(8, [&seen](Price px, const PriceLevel&) { seen.push_back(px); return true; });
+    assert(seen.size() == 2 && seen[0] == 1001 && seen[1] == 1000);
+  }
+
+  // Level totals track adds, partial fills and cancels; DEPTH walks best-first
+  MatchingEngine depth_eng;
+  depth_eng.new_limit_order(names.intern("m1"), Side::Sell, 10, 10.10);  // id 1
+  depth_eng.new_limit_order(names.intern("m2"), Side::Sell, 5, 10.10);   // id 2
+  depth_eng.new_limit_order(names.intern("m3"), Side::Sell, 7, 10.12);   // id 3
+  depth_eng.new_limit_order(names.intern("m4"), Side::Buy, 4, 10.05);    // id 4
+  depth_eng.new_market_order(names.intern("t1"), Side::Buy, 3);           // partial fill of id 1
+  assert(depth_eng.cancel(2));
+  std::vector<DepthLevel> bids, asks;
+  depth_eng.depth(10, bids, asks);
+  assert(bids.size() == 1 && bids[0].qty == 4 && bids[0].orders == 1);
+  assert(asks.size() == 2);
+  assert(asks[0].px == depth_eng.scale().to_ticks(10.10) && asks[0].qty == 7 && asks[0].orders == 1);
+  assert(asks[1].px == depth_eng.scale().to_ticks(10.12) && asks[1].qty == 7);
+  assert(depth_eng.top().ask_qty == 7);
+  depth_eng.depth(1, bids, asks);
+  assert(asks.size() == 1);
+
+  // touched(): the levels the last call changed, for the market-data feed
+  depth_eng.new_limit_order(names.intern("t2"), Side::Buy, 9, 10.12);  // sweeps 10.10, takes 2 at 10.12
+  const auto& tl = depth_eng.touched();
+  assert(tl.size() == 2 && tl[0].px == depth_eng.scale().to_ticks(10.10) && tl[0].side == Side::Sell);
+  assert(tl[1].px == depth_eng.scale().to_ticks(10.12) && tl[1].side == Side::Sell);
+  assert(depth_eng.level(Side::Sell, tl[0].px).qty == 0);
+  assert(depth_eng.level(Side::Buy, tl[1].px).qty == 0);
+  assert(depth_eng.level(Side::Sell, tl[1].px).qty == 5);
+  assert(depth_eng.cancel(4) && depth_eng.touched().size() == 1);
+
+  // REPLACE keeps queue priority only for a pure size decrease; mass cancel
+  // takes exactly one client's orders
+  {
+    MatchingEngine rep;
+    std::vector<Trade> fills;
+    ClientId q1 = names.intern("q1"), q2 = names.intern("q2");
+    rep.new_limit_order(q1, Side::Buy, 5, 10.00, fills);  // id 1
+    rep.new_limit_order(q2, Side::Buy, 5, 10.00, fills);  // id 2
+    rep.new_limit_order(q1, Side::Buy, 5, 9.90, fills);   // id 3
+    assert(rep.replace(1, 2, 10.00, fills) == ReplaceResult::Amended && rep.top().bid_qty == 7);
+    rep.new_market_order(alice, Side::Sell, 2, fills);
+    assert(fills.size() == 1 && fills[0].maker_id == 1);   // still first in line
+    assert(rep.replace(2, 6, 10.00, fills) == ReplaceResult::Requeued);
+    assert(rep.replace(9, 1, 10.00, fills) == ReplaceResult::NotFound);
+    assert(rep.replace(2, 1, 0.0, fills) == ReplaceResult::Rejected && rep.top().bid_qty == 6);
+    rep.new_limit_order(q2, Side::Sell, 4, 10.50, fills);  // id 5
+    assert(rep.replace(5, 8, 9.95, fills) == ReplaceResult::Requeued);  // crosses the 10.00 bid
+    assert(fills.size() == 1 && fills[0].taker_id == 5 && fills[0].qty == 6);
+    assert(rep.top().has_ask && rep.top().ask_qty == 2 && rep.resting_count() == 2);
+    assert(rep.cancel_all(q2) == 1 && rep.resting_count() == 1 && !rep.top().has_ask);
+    assert(rep.cancel_all(q2) == 0 && rep.cancel_all(q1) == 1 && rep.resting_count() == 0);
+  }
+
+  // wire prices carry the digits their tick needs, the same on every line
+  {
+    PriceScale cents, half_cents(0.005), nickels(0.05), whole(1.0);
+    assert(cents.decimals == 2 && half_cents.decimals == 3 && nickels.decimals == 2 && whole.decimals == 0);
+    assert(cents.format(1005) == "10.05" && half_cents.format(2001) == "10.005" && half_cents.format(2000) == "10.000");
+    assert(nickels.format(201) == "10.05" && whole.format(10) == "10" && whole.format(10.5, 1) == "10.5");
+  }
+
+  // off-grid limit prices are rejected, not rounded across the client's limit
+  {
+    MatchingEngine nickel(0.05);
+    std::vector<Trade> fills;
+    nickel.new_limit_order(alice, Side::Sell, 1, 10.05, fills);  // id 1
+    nickel.new_limit_order(names.intern("bob"), Side::Buy, 1, 9.95, fills);      // id 2
+    assert(!nickel.new_limit_order(names.intern("bob"), Side::Buy, 1, 10.03, fills) && fills.empty());
+    assert(!nickel.new_limit_order(alice, Side::Sell, 1, 9.97, fills) && fills.empty());
+    assert(!nickel.new_limit_order(names.intern("bob"), Side::Buy, 1, 0.03, fills));
+    assert(!nickel.new_limit_order(names.intern("bob"), Side::Buy, 1, 10.049999, fills));
+    assert(nickel.replace(2, 1, 10.03, fills) == ReplaceResult::Rejected && fills.empty());
+    assert(nickel.new_limit_order(names.intern("bob"), Side::Buy, 1, 10.05, fills) && fills.size() == 1);
+    assert(nickel.top().has_bid && nickel.top().bid_px == nickel.scale().to_ticks(9.95));
+  }
+
+  // Positions: average-cost realized PnL, through a flip from long to short
+  {
+    PositionBook pb;
+    ClientId mk = names.intern("pmaker"), tk = names.intern("ptaker");
+    auto fill = [&](Side taker_side, int qty, Price px) {
+      Trade t;
+      t.qty = qty;
+      t.px = px;
+      t.maker_client = mk;
+      t.taker_client = tk;
+      t.taker_side = taker_side;
+      t.maker_side = taker_side == Side::Buy ? Side::Sell : Side::Buy;
+      pb.on_fill(t);
+    };
+    fill(Side::Buy, 4, 1000);
+    fill(Side::Buy, 2, 1030);   // long 6, cost 6060
+    fill(Side::Sell, 9, 1050);  // closes 6 (+240), short 3 at 1050
+    const Position* p = pb.find(tk);
+    assert(p && p->qty == -3 && p->realized == 240 && p->open_cost == -3150);
+    assert(p->cash == -6060 + 9450 && p->volume == 15 && p->fills == 3);
+    assert(p->pnl(1040.0) == 240 + 30 && pb.last_px() == 1050);
+    const Position* m = pb.find(mk);
+    assert(m && m->qty == 3 && m->realized == -240 && m->pnl(1040.0) == -270);
+    assert(!pb.find(alice));
+  }
+
+  // Steady-state matching allocates nothing: order nodes come from the pool,
+  // far-level map nodes and index pages are recycled, fills reuse the sink
+  {
+    MatchingEngine pooled(0.01, /*ladder_window*/ 64, PoolConfig{4096, false});
+    std::vector<Trade> fills;
+    auto round = [&] {
+      for (int i = 0; i < 200; ++i) {
+        double px = 10.00 + (i % 40) * 0.01 + (i % 7 == 0 ? 5.00 : 0.0);  // some far levels
+        pooled.new_limit_order(alice, Side::Sell, 2, px, fills);
+      }
+      pooled.new_market_order(alice, Side::Buy, 300, fills);
+      for (int i = 0; i < 50; ++i) pooled.new_limit_order(alice, Side::Buy, 1, 9.50 - i * 0.01, fills);
+      pooled.new_limit_order(alice, Side::Sell, 60, 9.00, fills);  // sweep bids, rest 10 ask
+      pooled.new_market_order(alice, Side::Buy, 1000, fills);      // clear the asks
+    };
+    for (int i = 0; i < 20; ++i) round();  // warm up pool, free lists, vector capacity
+    size_t before = g_allocs;
+    for (int i = 0; i < 200; ++i) round();
+    assert(g_allocs == before);
+    assert(!pooled.top().has_bid && !pooled.top().has_ask);
+  }
+
+  // Slab cache: an engine's order pool goes back to the cache, and the next
+  // engine on the same thread takes it instead of mapping a new one
+  {
+    SlabCache slabs;
+    { MatchingEngine a(0.01, 64, PoolConfig{1024, false, &slabs}); }
+    assert(slabs.kept() == 1 && slabs.reused() == 0);
+    { MatchingEngine b(0.01, 64, PoolConfig{1024, false, &slabs}); }
+    assert(slabs.kept() == 1 && slabs.reused() == 1);
+  }
+
+  // Work-stealing pool: every task runs exactly once, on a valid worker;
+  // simulation runs are reproducible from their seed on any worker
+  {
+    std::vector<std::atomic<int>> ran(500);
+    {
+      WorkStealingPool pool(3);
+      for (size_t i = 0; i < ran.size(); ++i)
+        pool.submit([&ran, i, &pool](size_t w) { assert(w < pool.workers()); ran[i].fetch_add(1); });
+      pool.wait();
+      uint64_t executed = 0;
+      for (size_t w = 0; w < pool.workers(); ++w) executed += pool.executed(w);
+      assert(executed == ran.size());
+    }
+    for (auto& n : ran) assert(n.load() == 1);
+
+    SimConfig sc;
+    sc.steps = 2000;
+    SlabCache slabs;
+    RunResult a = run_simulation(sc, 7, &slabs), b = run_simulation(sc, 7, nullptr), c = run_simulation(sc, 8, &slabs);
+    assert(a.trades > 0 && a.trades == b.trades && a.volume == b.volume && a.mm_pnl == b.mm_pnl);
+    assert(a.mm_pnl + a.noise_pnl < 1e-6 && a.mm_pnl + a.noise_pnl > -1e-6);  // every fill has two sides
+    assert(c.volume != a.volume || c.mm_pnl != a.mm_pnl);
+  }
+
+  // Strategy host: a fill reaches both owners, then a trade and the book
+  // change reach everyone; MarketMaker keeps one quote per side
+  {
+    MatchingEngine e(0.01, 64);
+    EngineHost host(e);
+    Recorder maker(true), taker(false);
+    host.add(maker, 1);
+    size_t t = host.add(taker, 2);
+    host.start();
+    assert(maker.id != 0 && maker.books == 1 && taker.books == 1);
+    host.timer(t);
+    assert(maker.fills.size() == 1 && maker.fills[0].order_id == maker.id && maker.fills[0].side == Side::Sell);
+    assert(taker.fills.size() == 1 && taker.fills[0].side == Side::Buy && taker.fills[0].qty == 2);
+    assert(maker.trades == 1 && taker.trades == 1 && maker.books == 2 && e.top().ask_qty == 3);
+
+    MatchingEngine e2(0.01, 64);
+    EngineHost h2(e2);
+    MarketMaker mm(3, 5, 1000);
+    h2.add(mm, 1);
+    h2.timer(0);
+    h2.timer(0);  // same prices: replaced in place, nothing stacks
+    TopOfBook q = e2.top();
+    assert(q.bid_px == 995 && q.ask_px == 1005 && q.bid_qty == 3 && q.ask_qty == 3 && h2.orders() == 4);
+    h2.stop();
+    assert(!e2.top().has_bid && !e2.top().has_ask);
+  }
+
+  // Bars: trades and quotes land in their bucket; an empty gap is skipped,
+  // a quote-only bar carries the last close; the ring keeps the newest
+  {
+    const uint64_t s = 1000000000ull;
+    BarSeries bs(10 * s, 3);
+    TopOfBook q;
+    q.has_bid = q.has_ask = true;
+    q.bid_px = 995;
+    q.ask_px = 1005;
+    bs.on_quote(100 * s + 1, q);
+    bs.on_trade(101 * s, 1000, 2);
+    bs.on_trade(109 * s, 1010, 4);
+    bs.on_trade(105 * s, 990, 1);
+    bs.on_quote(131 * s, q);  // buckets 110 and 120 had nothing
+    std::vector<Bar> out;
+    bs.read(0, 10, out);
+    assert(out.size() == 2 && bs.last_closed() == 1);
+    assert(out[0].start_ns == 100 * s && out[0].open == 1000 && out[0].high == 1010 && out[0].low == 990);
+    assert(out[0].close == 990 && out[0].volume == 7 && out[0].notional == 2000 + 4040 + 990);
+    assert(out[0].quotes == 1 && out[0].spread_sum == 10);
+    assert(out[1].seq == 2 && out[1].start_ns == 130 * s && out[1].open == 990 && out[1].trades == 0);
+    for (uint64_t t = 140; t < 200; t += 10) bs.on_trade(t * s, 1000, 1);
+    out.clear();
+    bs.read(0, 10, out);
+    assert(out.size() == 3 && out[0].seq == 6 && out.back().seq == 8);
+    out.clear();
+    bs.read(7, 10, out);
+    assert(out.size() == 1 && out[0].seq == 8);
+  }
+
+  // Logger ring: FIFO, reports full, reuses cells after pops
+  MpscRing<int> ring(3);  // rounds up to 4
+  assert(ring.capacity() == 4);
+  assert(ring.empty() && ring.size_approx() == 0);
+  for (int i = 0; i < 4; ++i) assert(ring.try_push(i));
+  assert(!ring.try_push(99));
+  assert(!ring.empty() && ring.size_approx() == 4);
+  int v = -1;
+  assert(ring.try_pop(v) && v == 0);
+  assert(ring.try_push(4));
+  for (int want = 1; want <= 4; ++want) assert(ring.try_pop(v) && v == want);
+  assert(!ring.try_pop(v) && ring.empty());
+
+  // Trade ring: bounded history, SINCE reads, overwritten trades reported
+  TradeRing hist(4);
+  for (int i = 1; i <= 6; ++i) assert(hist.push(100 + i, i, Side::Buy) == static_cast<uint64_t>(i));
+  std::vector<TradeTick> got;
+  assert(hist.read(0, 10, got) == 2);  // seq 1,2 are gone
+  assert(got.size() == 4 && got.front().seq == 3 && got.back().seq == 6 && got.back().px == 106);
+  got.clear();
+  assert(hist.read(4, 1, got) == 0 && got.size() == 1 && got[0].seq == 5 && got[0].qty == 5);
+  got.clear();
+  assert(hist.read(6, 10, got) == 0 && got.empty());
+
+  // Trade journal: header + fixed records round-trip through the mmap reader
+  std::string jpath = "/tmp/tradesim_smoke_" + std::to_string(getpid()) + ".bin";
+  JournalSymbol js{};
+  std::strcpy(js.name, "XYZ");
+  js.ticks_per_unit = 20.0;  // 0.05 tick
+  int jfd = open_trade_journal(jpath, 42, {js});
+  assert(jfd >= 0);
+  JournalTrade jt{};
+  jt.px = 61;  // 3.05
+  jt.qty = 7;
+  jt.maker_side = 1;
+  std::strcpy(jt.maker_client, "carl");
+  assert(write(jfd, &jt, sizeof(jt)) == static_cast<ssize_t>(sizeof(jt)));
+  assert(write(jfd, &jt, 10) == 10);  // torn tail record is ignored
+  close(jfd);
+  {
+    TradeJournalReader jr;
+    assert(jr.open(jpath));
+    assert(jr.header().session_id == 42 && jr.header().symbol_count == 1);
+    assert(jr.size() == 1 && jr[0].qty == 7 && jr.to_px(jr[0]) == 3.05);
+    assert(std::strcmp(jr[0].maker_client, "carl") == 0);
+  }
+  std::remove(jpath.c_str());
+
+  // Input journal: commands come back in order after a restart; a snapshot
+  // retires them, and a torn tail ends replay without error
+  std::string sdir = "/tmp/tradesim_state_" + std::to_string(getpid());
+  {
+    ClientTable names;
+    InputJournalConfig icfg;
+    icfg.dir = sdir;
+    icfg.fsync = false;
+    InputJournal wal(icfg, names, {js});
+    assert(wal.open(1));
+    wal.start();
+    int done = 0;
+    InputCommand in;
+    in.kind = InputKind::NewLimit;
+    in.side = Side::Sell;
+    in.qty = 5;
+    in.px = 3.05;
+    in.client = names.intern("dora");
+    wal.append(in, [&](bool) { ++done; });
+    in.kind = InputKind::Cancel;
+    in.order_id = 1;
+    wal.append(in, [&](bool) { ++done; });
+    InputCommand again = in;
+    again.order_id = 2;
+    in.kind = InputKind::NewLimit;
+    wal.append_batch({in, again}, [&](bool) { done += 100; });  // two records, one continuation
+    wal.after([&](bool) { done += 10; });
+    wal.stop();
+    assert(done == 112 && wal.last_seq() == 4 && wal.stats().records == 4);
+  }
+  std::vector<std::pair<InputKind, std::string>> seen;
+  auto collect = [&](const InputCommand& c, std::string_view sym, std::string_view who) {
+    assert(sym == "XYZ" && c.qty == 5 && c.side == Side::Sell);
+    seen.emplace_back(c.kind, std::string(who));
+  };
+  assert(replay_input(sdir, 0, collect) == 4);
+  assert(seen.size() == 4 && seen[0].first == InputKind::NewLimit && seen[1].first == InputKind::Cancel);
+  assert(seen[2].first == InputKind::NewLimit && seen[3].first == InputKind::Cancel);
+  assert(seen[0].second == "dora" && seen[3].second == "dora");
+  seen.clear();
+  assert(replay_input(sdir, 1, collect) == 4 && seen.size() == 3);
+  std::string seg = sdir + "/input_00000000000000000001.log";
+  {
+    FILE* f = std::fopen(seg.c_str(), "ab");
+    std::fputs("torn", f);
+    std::fclose(f);
+  }
+  seen.clear();
+  assert(replay_input(sdir, 0, collect) == 4 && seen.size() == 4);
+  {
+    // one segment's bytes on their own, as tradesim_replay maps them
+    std::string bytes;
+    FILE* f = std::fopen(seg.c_str(), "rb");
+    char buf[4096];
+    for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) bytes.append(buf, n);
+    std::fclose(f);
+    InputSegmentHeader sh;
+    assert(read_segment_header(bytes, sh) && sh.first_seq == 1 && sh.symbol_count == 1);
+    uint64_t last = 2;
+    seen.clear();
+    assert(replay_segment(bytes, last, collect) && last == 4 && seen.size() == 2);
+  }
+
+  // Wire grammar shared by the server and tradesim_replay
+  {
+    ClientTable names;
+    InputCommand c;
+    std::string err;
+    TokenViews t = token_views("NEW LIMIT BUY 10 @ 9.95 CLIENT ann SYMBOL XYZ");
+    assert(take_symbol(t) == "XYZ");
+    assert(parse_command(t, names, c, err) && c.kind == InputKind::NewLimit && c.qty == 10 && c.px == 9.95);
+    assert(names.name(c.client) == "ann");
+    t = token_views("CANCEL ALL CLIENT ann");
+    assert(parse_command(t, names, c, err) && c.kind == InputKind::CancelAll && names.name(c.client) == "ann");
+    t = token_views("REPLACE 7 0 @ 1.00");
+    assert(!parse_command(t, names, c, err) && err == "ERROR usage: REPLACE <id> <qty> @ <px>");
+    // orders that would never exist are refused, not acked with an id
+    t = token_views("NEW MARKET BUY 0 CLIENT ann");
+    assert(!parse_command(t, names, c, err) && err == "ERROR bad quantity");
+    t = token_views("NEW LIMIT SELL 3 @ -1 CLIENT ann");
+    assert(!parse_command(t, names, c, err) && err == "ERROR bad price");
+    MatchingEngine e(0.05, 64);
+    std::vector<Trade> f;
+    assert(!e.new_limit_order(c.client, Side::Sell, 3, 0.02, f) && !e.new_market_order(c.client, Side::Buy, 0, f));
+    assert(e.new_limit_order(c.client, Side::Sell, 3, 0.05, f) && e.top().has_ask && !e.top().has_bid);
+  }
+  assert(write_snapshot_file(sdir, 4, "blob"));
+  prune_journal(sdir, 4);
+  assert(access(seg.c_str(), F_OK) == 0);  // newest segment may still grow: kept
+  uint64_t snap_seq = 0;
+  std::string blob;
+  assert(load_latest_snapshot(sdir, snap_seq, blob) && snap_seq == 4 && blob == "blob");
+  seen.clear();
+  assert(replay_input(sdir, 4, collect) == 4 && seen.empty());
+  std::remove((sdir + "/snapshot_00000000000000000004.bin").c_str());
+  std::remove(seg.c_str());
+  rmdir(sdir.c_str());
+
+  // A failed journal write (here: the file size limit, mid-record) acks
+  // nothing from then on and writes nothing past the torn record
+  {
+    ClientTable names;
+    InputJournalConfig icfg;
+    icfg.dir = sdir;
+    icfg.fsync = false;
+    InputJournal wal(icfg, names, {js});
+    assert(wal.open(1));
+    const size_t rec = sizeof(InputRecord) + 3;  // + "eve"
+    rlimit old{};
+    getrlimit(RLIMIT_FSIZE, &old);
+    rlimit small = old;
+    small.rlim_cur = sizeof(InputSegmentHeader) + rec + rec / 2;
+    auto prev = std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &small);
+    wal.start();
+    InputCommand in;
+    in.qty = 1;
+    in.px = 1.0;
+    in.client = names.intern("eve");
+    std::atomic<int> acks{0}, naks{0};
+    auto done = [&](bool durable) { ++(durable ? acks : naks); };
+    auto wait_for = [&](int n) { while (acks + naks < n) usleep(100); };
+    wal.append(in, done);
+    wait_for(1);
+    wal.append(in, done);  // torn
+    wait_for(2);
+    setrlimit(RLIMIT_FSIZE, &old);
+    wal.append(in, done);  // would fit again: still refused
+    wal.stop();
+    std::signal(SIGXFSZ, prev);
+    assert(acks == 1 && naks == 2 && wal.failed() && wal.last_seq() == 1);
+    std::string path = sdir + "/input_00000000000000000001.log";
+    struct stat st{};
+    assert(stat(path.c_str(), &st) == 0 && static_cast<size_t>(st.st_size) == small.rlim_cur);
+    assert(replay_input(sdir, 0, [](const InputCommand&, std::string_view, std::string_view) {}) == 1);
+    std::remove(path.c_str());
+    rmdir(sdir.c_str());
+  }
+
+  // Latency histogram: exact below 128, within 1/64 above, max kept exactly
+  {
+    static LatencyHistogram h;  // ~30 KB of buckets
+    for (uint64_t v = 1; v <= 100; ++v) h.record(v);
+    assert(h.count() == 100 && h.percentile(0.5) == 50 && h.percentile(0.99) == 99);
+    h.record(1000000);
+    uint64_t top = h.percentile(1.0);
+    assert(top == 1000000 && h.max() == 1000000 && h.min() == 1);
+    h.reset();
+    h.record(123456789);
+    uint64_t p = h.percentile(0.5);
+    assert(p >= 123456789 && p - 123456789 <= 123456789 / 64);
+
+    // per-thread metric buckets read back into a histogram
+    static ShardMetrics sm;
+    sm.record(CmdKind::Cancel, 1000, 1500, 2000);
+    sm.record(CmdKind::Cancel, 1000, 1900, 2000);
+    h.reset();
+    sm.latency[static_cast<size_t>(CmdKind::Cancel)].add_to(h);
+    assert(sm.commands[static_cast<size_t>(CmdKind::Cancel)].load() == 2);
+    assert(h.count() == 2 && h.percentile(0.5) >= 1000 && h.percentile(0.5) <= 1000 + 1000 / 64);
+  }
+
+  // A line pushed while a reply is owed waits for it: the MD FILL of an
+  // order goes out after the order's ack, never ahead of it
+  {
+    EventLoop loop([](const std::shared_ptr<Connection>&) {},
+                   [](const std::shared_ptr<Connection>& c, std::string_view) {
+                     uint64_t slot = c->reserve();                 // answered by a matching thread...
+                     c->send("MD FILL AUM 1 1 5@10.00 BUY");      // ...whose fill reached the feed first
+                     c->deliver(slot, "OK 1");
+                   });
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0 && loop.start());
+    loop.adopt(sv[0]);
+    assert(write(sv[1], "NEW\n", 4) == 4);
+    std::string got;
+    char buf[256];
+    for (ssize_t n; got.size() < 33 && (n = read(sv[1], buf, sizeof(buf))) > 0;) got.append(buf, n);
+    assert(got == "OK 1\nMD FILL AUM 1 1 5@10.00 BUY\n");
+    loop.stop();
+    close(sv[1]);
+  }
 
   std::cout << "SMOKE TEST PASSED\n";
   return 0;
@@ -0,0 +1,44 @@
+// Converts a binary trade journal (logs/<session>_trades.bin) to the CSV
+// layout the server used to write, for tools that still read CSV.
+//
+//   journal_to_csv logs/<session>_trades.bin [out.csv]   (default: stdout)
+#include "common/trade_journal.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace ts;
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    std::fprintf(stderr, "usage: journal_to_csv <trades.bin> [out.csv]\n");
+    return 1;
+  }
+  TradeJournalReader j;
+  if (!j.open(argv[1])) {
+    std::fprintf(stderr, "%s\n", j.error().c_str());
+    return 1;
+  }
+  std::FILE* out = argc == 3 ? std::fopen(argv[2], "w") : stdout;
+  if (!out) {
+    std::perror(argv[2]);
+    return 1;
+  }
+
+  const JournalHeader& h = j.header();
+  std::fputs("ts_ns,maker_id,taker_id,qty,px,maker_client,taker_client,maker_side,taker_side,symbol\n", out);
+  for (const JournalTrade& t : j) {
+    char sym[sizeof(h.symbols[0].name) + 1] = "";
+    if (t.symbol < h.symbol_count) std::memcpy(sym, h.symbols[t.symbol].name, sizeof(h.symbols[0].name));
+    double px = t.symbol < h.symbol_count ? j.to_px(t) : 0.0;
+    std::fprintf(out, "%llu,%llu,%llu,%d,%f,%.*s,%.*s,%s,%s,%s\n",
+                 static_cast<unsigned long long>(t.ts_ns),
+                 static_cast<unsigned long long>(t.maker_id),
+                 static_cast<unsigned long long>(t.taker_id), t.qty, px,
+                 static_cast<int>(strnlen(t.maker_client, sizeof(t.maker_client))), t.maker_client,
+                 static_cast<int>(strnlen(t.taker_client, sizeof(t.taker_client))), t.taker_client,
+                 t.maker_side == 0 ? "BUY" : "SELL", t.taker_side == 0 ? "BUY" : "SELL", sym);
+  }
+  if (out != stdout) std::fclose(out);
+  return 0;
+}
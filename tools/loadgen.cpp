@@ -0,0 +1,330 @@
+// Open-loop load generator: N connections send orders on a fixed schedule
+// whatever the reply timing, and every reply's latency is measured from the
+// moment its order was *due*, not when it was actually written, so a
+// stalled server shows up as latency instead of silently lowering the load.
+//
+//   loadgen [host=127.0.0.1] [port=5555] [conns=16] [threads=4]
+//           [rate=20000 | rates=5000,10000,20000,40000] [duration=10] [warmup=1]
+//           [arrival=uniform|poisson] [symbol=<name>] [seed=1] [json=path]
+//
+// rate is orders/s across all connections. With rates= each step runs for
+// duration seconds (the first warmup seconds unrecorded) and the report ends
+// with the knee: the highest rate still sustained (>= 95% of target replies)
+// with p99 under 3x that of the lowest rate.
+#include "common/latency_histogram.hpp"
+#include "net/client.hpp"
+#include <poll.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ts;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  std::string host{"127.0.0.1"};
+  int port{5555};
+  size_t conns{16};
+  size_t threads{4};
+  std::vector<double> rates{20000};
+  double duration{10};
+  double warmup{1};
+  bool poisson{false};
+  std::string symbol;
+  uint32_t seed{1};
+  std::string json;
+};
+
+struct StepStats {
+  uint64_t sent{0};
+  uint64_t replies{0};
+  uint64_t errors{0};      // ERROR replies
+  uint64_t timeouts{0};    // no reply by the end of the drain
+  uint64_t send_fail{0};   // connections lost
+  LatencyHistogram hist;   // recorded replies only, ns
+
+  void merge(const StepStats& o) {
+    sent += o.sent;
+    replies += o.replies;
+    errors += o.errors;
+    timeouts += o.timeouts;
+    send_fail += o.send_fail;
+    hist.merge(o.hist);
+  }
+};
+
+struct Conn {
+  Client client;
+  std::string name;
+  Clock::time_point next_send;
+  std::deque<std::pair<Clock::time_point, bool>> pending;  // due time, recorded
+  bool alive{true};
+};
+
+// One thread's share of the connections for one rate step.
+class Worker {
+public:
+  Worker(const Options& opt, std::vector<Conn*> conns, uint32_t seed)
+      : opt_(opt), conns_(std::move(conns)), rng_(seed) {}
+
+  void run_step(double rate_per_conn, Clock::time_point start, StepStats& st) {
+    interval_ = 1.0 / rate_per_conn;
+    const auto record_from = start + secs(opt_.warmup);
+    const auto stop = start + secs(opt_.duration);
+    const auto give_up = stop + std::chrono::seconds(2);
+    for (Conn* c : conns_) c->next_send = start + secs(gap() * uniform01());  // spread phases
+
+    std::vector<pollfd> fds(conns_.size());
+    std::string line;
+    while (true) {
+      auto now = Clock::now();
+      bool sending = now < stop;
+      Clock::time_point wake = give_up;
+      for (Conn* c : conns_) {
+        if (!c->alive) continue;
+        while (sending && c->next_send <= now) {
+          if (!c->client.send_line(make_order(*c))) { lose(*c, st); break; }
+          c->pending.emplace_back(c->next_send, c->next_send >= record_from);
+          ++st.sent;
+          c->next_send += secs(gap());
+        }
+        if (sending && c->alive) wake = std::min(wake, c->next_send);
+      }
+
+      bool waiting = false;
+      for (size_t i = 0; i < conns_.size(); ++i) {
+        fds[i] = pollfd{conns_[i]->alive ? conns_[i]->client.fd() : -1, POLLIN, 0};
+        waiting |= conns_[i]->alive && !conns_[i]->pending.empty();
+      }
+      if (!sending && (!waiting || now >= give_up)) break;
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(wake - Clock::now()).count();
+      int n = ::poll(fds.data(), fds.size(), static_cast<int>(std::max<long long>(left, 0)));
+      if (n <= 0) continue;
+
+      for (size_t i = 0; i < conns_.size(); ++i) {
+        if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        Conn& c = *conns_[i];
+        int r;
+        while ((r = c.client.try_read_line(line, 0)) == 1) {
+          if (c.pending.empty()) continue;  // not a reply to us
+          auto [due, record] = c.pending.front();
+          c.pending.pop_front();
+          if (!record) continue;
+          ++st.replies;
+          if (line.compare(0, 5, "ERROR") == 0) ++st.errors;
+          st.hist.record(static_cast<uint64_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count()));
+        }
+        if (r < 0) lose(c, st);
+      }
+    }
+    for (Conn* c : conns_) {
+      for (auto& p : c->pending) st.timeouts += p.second;
+      c->pending.clear();
+    }
+  }
+
+private:
+  const Options& opt_;
+  std::vector<Conn*> conns_;
+  std::mt19937 rng_;
+  double interval_{0};
+  long mid_{10000};  // ticks of 0.01
+  uint64_t n_{0};
+
+  static Clock::duration secs(double s) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+  }
+  double uniform01() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng_); }
+  double gap() { return opt_.poisson ? std::exponential_distribution<double>(1.0 / interval_)(rng_) : interval_; }
+
+  void lose(Conn& c, StepStats& st) {
+    c.alive = false;
+    ++st.send_fail;
+    for (auto& p : c.pending) st.timeouts += p.second;
+    c.pending.clear();
+    c.client.close();
+  }
+
+  // 60% passive within 20 ticks of a drifting mid, 40% crossing by up to
+  // 3 ticks: both sides alike, so the book stays roughly the same size
+  std::string make_order(const Conn& c) {
+    if (++n_ % 64 == 0) mid_ += std::uniform_int_distribution<int>(-1, 1)(rng_);
+    bool buy = (rng_() & 1) != 0;
+    bool cross = std::uniform_int_distribution<int>(0, 9)(rng_) < 4;
+    long off = cross ? -std::uniform_int_distribution<int>(0, 3)(rng_) : std::uniform_int_distribution<int>(1, 20)(rng_);
+    long ticks = buy ? mid_ - off : mid_ + off;
+    int qty = std::uniform_int_distribution<int>(1, 10)(rng_);
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "NEW LIMIT %s %d @ %ld.%02ld CLIENT %s%s%s", buy ? "BUY" : "SELL", qty,
+                  ticks / 100, ticks % 100, c.name.c_str(), opt_.symbol.empty() ? "" : " SYMBOL ",
+                  opt_.symbol.c_str());
+    return buf;
+  }
+};
+
+std::vector<double> parse_rates(const std::string& s) {
+  std::vector<double> out;
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) if (!item.empty()) out.push_back(std::stod(item));
+  return out;
+}
+
+double us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+struct StepResult {
+  double target;
+  double achieved;  // recorded replies / recorded seconds
+  StepStats st;
+};
+
+void print_step(const StepResult& r) {
+  const LatencyHistogram& h = r.st.hist;
+  std::printf("%10.0f %10.0f %9llu %7llu %7llu %9.1f %9.1f %9.1f %9.1f %10.1f\n", r.target, r.achieved,
+              static_cast<unsigned long long>(r.st.replies), static_cast<unsigned long long>(r.st.errors),
+              static_cast<unsigned long long>(r.st.timeouts + r.st.send_fail), us(h.percentile(0.50)),
+              us(h.percentile(0.90)), us(h.percentile(0.99)), us(h.percentile(0.999)), us(h.max()));
+  std::fflush(stdout);
+}
+
+bool sustained(const StepResult& r) { return r.achieved >= 0.95 * r.target && r.st.timeouts == 0; }
+
+// index of the knee step, or -1 if even the first rate was not sustained
+int find_knee(const std::vector<StepResult>& steps) {
+  if (steps.empty() || !sustained(steps.front())) return -1;
+  uint64_t base = std::max<uint64_t>(steps.front().st.hist.percentile(0.99), 1);
+  int knee = 0;
+  for (size_t i = 1; i < steps.size(); ++i) {
+    if (!sustained(steps[i]) || steps[i].st.hist.percentile(0.99) > 3 * base) break;
+    knee = static_cast<int>(i);
+  }
+  return knee;
+}
+
+bool write_json(const Options& opt, const std::vector<StepResult>& steps, int knee) {
+  FILE* f = std::fopen(opt.json.c_str(), "w");
+  if (!f) return false;
+  std::fprintf(f, "{\n  \"tool\": \"loadgen\",\n  \"format\": 1,\n  \"conns\": %zu,\n  \"duration_s\": %.3f,\n"
+                  "  \"warmup_s\": %.3f,\n  \"arrival\": \"%s\",\n  \"steps\": [",
+               opt.conns, opt.duration, opt.warmup, opt.poisson ? "poisson" : "uniform");
+  for (size_t i = 0; i < steps.size(); ++i) {
+    const StepResult& r = steps[i];
+    const LatencyHistogram& h = r.st.hist;
+    std::fprintf(f, "%s\n    {\"target_rate\": %.0f, \"achieved_rate\": %.1f, \"sent\": %llu, \"replies\": %llu, "
+                    "\"errors\": %llu, \"timeouts\": %llu, \"lost_conns\": %llu, \"latency_ns\": {\"mean\": %.0f, "
+                    "\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99.9\": %llu, \"max\": %llu}}",
+                 i ? "," : "", r.target, r.achieved, static_cast<unsigned long long>(r.st.sent),
+                 static_cast<unsigned long long>(r.st.replies), static_cast<unsigned long long>(r.st.errors),
+                 static_cast<unsigned long long>(r.st.timeouts), static_cast<unsigned long long>(r.st.send_fail),
+                 h.mean(), static_cast<unsigned long long>(h.percentile(0.50)),
+                 static_cast<unsigned long long>(h.percentile(0.90)),
+                 static_cast<unsigned long long>(h.percentile(0.99)),
+                 static_cast<unsigned long long>(h.percentile(0.999)), static_cast<unsigned long long>(h.max()));
+  }
+  std::fprintf(f, "\n  ],\n  \"knee_rate\": %.0f\n}\n", knee >= 0 ? steps[static_cast<size_t>(knee)].target : 0.0);
+  return std::fclose(f) == 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: loadgen [host=127.0.0.1] [port=5555] [conns=16] [threads=4]\n"
+               "               [rate=20000 | rates=a,b,...] [duration=10] [warmup=1]\n"
+               "               [arrival=uniform|poisson] [symbol=<name>] [seed=1] [json=path]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto eq = arg.find('=');
+      if (eq == std::string::npos) throw std::invalid_argument(arg);
+      std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+      if (key == "host") opt.host = val;
+      else if (key == "port") opt.port = std::stoi(val);
+      else if (key == "conns") opt.conns = std::stoul(val);
+      else if (key == "threads") opt.threads = std::stoul(val);
+      else if (key == "rate" || key == "rates") opt.rates = parse_rates(val);
+      else if (key == "duration") opt.duration = std::stod(val);
+      else if (key == "warmup") opt.warmup = std::stod(val);
+      else if (key == "arrival" && (val == "uniform" || val == "poisson")) opt.poisson = (val == "poisson");
+      else if (key == "symbol") opt.symbol = val;
+      else if (key == "seed") opt.seed = static_cast<uint32_t>(std::stoul(val));
+      else if (key == "json") opt.json = val;
+      else throw std::invalid_argument(arg);
+    }
+  } catch (...) {
+    usage();
+    return 1;
+  }
+  if (opt.conns == 0 || opt.rates.empty() || opt.warmup >= opt.duration ||
+      std::any_of(opt.rates.begin(), opt.rates.end(), [](double r) { return r <= 0; })) {
+    usage();
+    return 1;
+  }
+  opt.threads = std::max<size_t>(1, std::min(opt.threads, opt.conns));
+
+  std::vector<std::unique_ptr<Conn>> conns;
+  std::string greeting;
+  for (size_t i = 0; i < opt.conns; ++i) {
+    auto c = std::make_unique<Conn>();
+    c->name = "lg" + std::to_string(i);
+    if (!c->client.connect(opt.host, opt.port) || !c->client.read_line(greeting)) {
+      std::fprintf(stderr, "connect %s:%d failed (connection %zu)\n", opt.host.c_str(), opt.port, i);
+      return 2;
+    }
+    conns.push_back(std::move(c));
+  }
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (size_t t = 0; t < opt.threads; ++t) {
+    std::vector<Conn*> mine;
+    for (size_t i = t; i < conns.size(); i += opt.threads) mine.push_back(conns[i].get());
+    workers.push_back(std::make_unique<Worker>(opt, std::move(mine), opt.seed + static_cast<uint32_t>(t)));
+  }
+
+  std::printf("%zu connections on %zu threads, %.0fs steps (%.0fs warmup), %s arrivals\n", opt.conns, opt.threads,
+              opt.duration, opt.warmup, opt.poisson ? "poisson" : "uniform");
+  std::printf("%10s %10s %9s %7s %7s %9s %9s %9s %9s %10s\n", "target/s", "replies/s", "replies", "errors", "lost",
+              "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+  std::vector<StepResult> steps;
+  for (double rate : opt.rates) {
+    std::vector<StepStats> per(workers.size());
+    std::vector<std::thread> th;
+    auto start = Clock::now() + std::chrono::milliseconds(50);
+    double per_conn = rate / static_cast<double>(opt.conns);
+    for (size_t t = 0; t < workers.size(); ++t)
+      th.emplace_back([&, t] { workers[t]->run_step(per_conn, start, per[t]); });
+    for (auto& x : th) x.join();
+
+    StepResult r{rate, 0, {}};
+    for (auto& s : per) r.st.merge(s);
+    r.achieved = static_cast<double>(r.st.replies) / (opt.duration - opt.warmup);
+    print_step(r);
+    steps.push_back(std::move(r));
+  }
+
+  int knee = find_knee(steps);
+  if (steps.size() > 1) {
+    if (knee < 0) std::printf("knee: below %.0f/s (lowest rate not sustained)\n", steps.front().target);
+    else std::printf("knee: %.0f orders/s\n", steps[static_cast<size_t>(knee)].target);
+  }
+  if (!opt.json.empty() && !write_json(opt, steps, knee)) {
+    std::fprintf(stderr, "cannot write %s\n", opt.json.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,191 @@
+// Monte Carlo runner: the same bot population run many times with different
+// seeds, each run a private MatchingEngine on one core (sim/simulation.hpp),
+// spread over a work-stealing pool. Each worker keeps its own slab cache, so
+// engines built and torn down run after run never go back to the OS, and
+// runs share nothing but their result slot.
+//
+//   tradesim_mc [runs=200] [seed=1] [threads=0 | threads=1,2,4,8] [steps=20000]
+//               [mm=4] [noise=16] [mm_qty=5] [half_spread=5] [trade_prob=0.3]
+//               [noise_qty=5] [out=mc_summary.csv]
+//
+// Run i uses seed+i. out= gets one CSV row per run (PnL, volume, spread
+// stats); stdout gets runs/s and the distribution over runs. With several
+// thread counts the batch is repeated at each, for a scaling table, and the
+// results are checked identical across them (threads=0: all hardware threads).
+#include "common/work_pool.hpp"
+#include "engine/pool.hpp"
+#include "sim/simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ts;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  size_t runs{200};
+  uint64_t seed{1};
+  std::vector<size_t> threads{0};
+  SimConfig sim;
+  std::string out{"mc_summary.csv"};
+};
+
+std::vector<size_t> parse_list(const std::string& s) {
+  std::vector<size_t> out;
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) if (!item.empty()) out.push_back(std::stoul(item));
+  if (out.empty()) throw std::invalid_argument(s);
+  return out;
+}
+
+bool same(const RunResult& a, const RunResult& b) {
+  return a.orders == b.orders && a.trades == b.trades && a.volume == b.volume && a.final_mid == b.final_mid &&
+         a.mean_spread == b.mean_spread && a.max_spread == b.max_spread && a.mm_pnl == b.mm_pnl &&
+         a.noise_pnl == b.noise_pnl && a.best_pnl == b.best_pnl && a.worst_pnl == b.worst_pnl;
+}
+
+// one batch on a pool of n workers; returns wall seconds
+double run_batch(const Options& opt, size_t n, std::vector<RunResult>& results) {
+  results.assign(opt.runs, RunResult{});
+  WorkStealingPool pool(n);
+  std::vector<std::unique_ptr<SlabCache>> slabs;
+  for (size_t w = 0; w < pool.workers(); ++w) slabs.push_back(std::make_unique<SlabCache>());
+
+  auto t0 = Clock::now();
+  for (size_t i = 0; i < opt.runs; ++i) {
+    pool.submit([&, i](size_t worker) { results[i] = run_simulation(opt.sim, opt.seed + i, slabs[worker].get()); });
+  }
+  pool.wait();
+  double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  uint64_t orders = 0;
+  for (const auto& r : results) orders += r.orders;
+  std::printf("threads %-3zu %8.3f s  %9.1f runs/s  %7.2f M orders/s   per worker (runs/stolen):", pool.workers(),
+              secs, static_cast<double>(opt.runs) / secs, static_cast<double>(orders) / secs / 1e6);
+  uint64_t reused = 0;
+  for (size_t w = 0; w < pool.workers(); ++w) {
+    std::printf(" %llu/%llu", static_cast<unsigned long long>(pool.executed(w)),
+                static_cast<unsigned long long>(pool.stolen(w)));
+    reused += slabs[w]->reused();
+  }
+  std::printf("  slabs reused %llu\n", static_cast<unsigned long long>(reused));
+  return secs;
+}
+
+// mean, stdev and p5/p50/p95 of one field over the runs
+void describe(const char* name, const std::vector<RunResult>& results, double (*field)(const RunResult&)) {
+  std::vector<double> v;
+  for (const auto& r : results) v.push_back(field(r));
+  std::sort(v.begin(), v.end());
+  double mean = 0, var = 0;
+  for (double x : v) mean += x;
+  mean /= static_cast<double>(v.size());
+  for (double x : v) var += (x - mean) * (x - mean);
+  double sd = v.size() > 1 ? std::sqrt(var / static_cast<double>(v.size() - 1)) : 0.0;
+  auto pct = [&](double p) { return v[static_cast<size_t>(p * static_cast<double>(v.size() - 1))]; };
+  std::printf("  %-18s mean %12.4f  sd %12.4f  p5 %12.4f  p50 %12.4f  p95 %12.4f\n", name, mean, sd, pct(0.05),
+              pct(0.5), pct(0.95));
+}
+
+bool write_summary(const std::string& path, const std::vector<RunResult>& results) {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fputs("run,seed,orders,trades,volume,final_mid,mean_spread_ticks,max_spread_ticks,two_sided,"
+             "low_ticks,high_ticks,mm_pnl,noise_pnl,best_pnl,worst_pnl\n", f);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const RunResult& r = results[i];
+    std::fprintf(f, "%zu,%llu,%llu,%llu,%llu,%.6f,%.4f,%lld,%.4f,%lld,%lld,%.4f,%.4f,%.4f,%.4f\n", i,
+                 static_cast<unsigned long long>(r.seed), static_cast<unsigned long long>(r.orders),
+                 static_cast<unsigned long long>(r.trades), static_cast<unsigned long long>(r.volume), r.final_mid,
+                 r.mean_spread, static_cast<long long>(r.max_spread), r.two_sided, static_cast<long long>(r.low),
+                 static_cast<long long>(r.high), r.mm_pnl, r.noise_pnl, r.best_pnl, r.worst_pnl);
+  }
+  return std::fclose(f) == 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: tradesim_mc [runs=200] [seed=1] [threads=0 | threads=1,2,4,8] [steps=20000]\n"
+               "                   [mm=4] [noise=16] [mm_qty=5] [half_spread=5] [trade_prob=0.3]\n"
+               "                   [noise_qty=5] [out=mc_summary.csv]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto eq = arg.find('=');
+      if (eq == std::string::npos) throw std::invalid_argument(arg);
+      std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+      if (key == "runs") opt.runs = std::stoul(val);
+      else if (key == "seed") opt.seed = std::stoull(val);
+      else if (key == "threads") opt.threads = parse_list(val);
+      else if (key == "steps") opt.sim.steps = std::stoul(val);
+      else if (key == "mm") opt.sim.market_makers = std::stoul(val);
+      else if (key == "noise") opt.sim.noise_traders = std::stoul(val);
+      else if (key == "mm_qty") opt.sim.mm_qty = std::stoi(val);
+      else if (key == "half_spread") opt.sim.max_half_spread = std::stoi(val);
+      else if (key == "trade_prob") opt.sim.trade_prob = std::stod(val);
+      else if (key == "noise_qty") opt.sim.noise_max_qty = std::stoi(val);
+      else if (key == "out") opt.out = val;
+      else throw std::invalid_argument(arg);
+    }
+    if (opt.runs == 0 || opt.sim.mm_qty <= 0 || opt.sim.trade_prob < 0 || opt.sim.trade_prob > 1)
+      throw std::invalid_argument("runs, mm_qty or trade_prob");
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "bad argument: %s\n", e.what());
+    usage();
+    return 1;
+  }
+
+  std::printf("%zu runs x %zu steps, %zu market makers + %zu noise traders, seeds %llu..%llu\n", opt.runs,
+              opt.sim.steps, opt.sim.market_makers, opt.sim.noise_traders,
+              static_cast<unsigned long long>(opt.seed), static_cast<unsigned long long>(opt.seed + opt.runs - 1));
+  std::vector<RunResult> results, first;
+  double base = 0;
+  for (size_t k = 0; k < opt.threads.size(); ++k) {
+    double secs = run_batch(opt, opt.threads[k], results);
+    if (k == 0) {
+      base = secs;
+      first = results;
+      continue;
+    }
+    std::printf("            speedup %.2fx over the first\n", base / secs);
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!same(results[i], first[i])) {
+        std::fprintf(stderr, "run %zu (seed %llu) differs between thread counts\n", i,
+                     static_cast<unsigned long long>(results[i].seed));
+        return 2;
+      }
+    }
+  }
+
+  std::printf("over %zu runs:\n", results.size());
+  describe("mm_pnl", results, [](const RunResult& r) { return r.mm_pnl; });
+  describe("noise_pnl", results, [](const RunResult& r) { return r.noise_pnl; });
+  describe("volume", results, [](const RunResult& r) { return static_cast<double>(r.volume); });
+  describe("mean_spread_ticks", results, [](const RunResult& r) { return r.mean_spread; });
+  describe("two_sided", results, [](const RunResult& r) { return r.two_sided; });
+  describe("final_mid", results, [](const RunResult& r) { return r.final_mid; });
+  if (!opt.out.empty()) {
+    if (!write_summary(opt.out, results)) {
+      std::perror(opt.out.c_str());
+      return 1;
+    }
+    std::printf("wrote %s\n", opt.out.c_str());
+  }
+  return 0;
+}
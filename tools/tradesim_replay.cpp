@@ -0,0 +1,449 @@
+// Offline replay / backtest: streams recorded or synthetic order flow
+// through MatchingEngine with no sockets and no threads in the way, as fast
+// as one core allows, and writes trades and book rows in the server's own
+// log formats.
+//
+//   tradesim_replay <file>... [symbols=AUM,XYZ:0.05] [out=<prefix>] [book_every=N]
+//                   [verify=<trades.bin>] [verify_ts=0|1]
+//
+// Each file is mmapped and read by its format:
+//   - an input journal segment (state/input_*.log): a recorded session.
+//     Pass every segment in order; books start empty, so order ids match the
+//     recording only if it begins at command 1 (no older segment pruned).
+//   - text: one command per line in the wire grammar (NEW LIMIT/MARKET,
+//     CANCEL, REPLACE, CANCEL ALL CLIENT, optional SYMBOL <name>). BOOK logs
+//     a book row; '#' comments and other commands are skipped.
+// Symbols come from symbols= (default AUM) followed by those named in
+// segment headers, in order of first appearance.
+//
+// out= writes <prefix>_trades.bin and <prefix>_book.csv (replacing them).
+// Records are stamped with the command number (journal seq, or line number)
+// instead of a clock, so replays of the same input are byte-identical.
+// verify= compares each trade, in order, with a reference trade journal
+// byte for byte; ts_ns is left out unless verify_ts=1, as a live session
+// stamps clock time. Exit status: 0 ok, 1 usage or I/O error, 2 mismatch.
+#include "common/client_table.hpp"
+#include "common/input_journal.hpp"
+#include "common/logger.hpp"
+#include "common/trade_journal.hpp"
+#include "common/util.hpp"
+#include "engine/matching_engine.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+using namespace ts;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  std::vector<std::string> files;
+  std::string symbols;
+  std::string out;
+  uint64_t book_every{0};
+  std::string verify;
+  bool verify_ts{false};
+};
+
+// Read-only mapping of a whole file.
+class MappedFile {
+public:
+  ~MappedFile() {
+    if (base_) ::munmap(const_cast<char*>(base_), size_);
+  }
+  bool open(const std::string& path, std::string& err) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { err = path + ": " + std::strerror(errno); return false; }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); err = path + ": " + std::strerror(errno); return false; }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) { ::close(fd); return true; }
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { err = path + ": mmap failed"; size_ = 0; return false; }
+    base_ = static_cast<const char*>(p);
+    (void)::madvise(p, size_, MADV_SEQUENTIAL);
+    return true;
+  }
+  std::string_view data() const { return {base_, size_}; }
+
+private:
+  const char* base_{nullptr};
+  size_t size_{0};
+};
+
+struct Book {
+  Book(std::string name, uint16_t index, double tick) : symbol(std::move(name)), id(index), engine(tick) {}
+  std::string symbol;
+  uint16_t id;  // index in the output journal's symbol table
+  MatchingEngine engine;
+  std::vector<Trade> fills;
+  uint64_t trades{0};
+};
+
+class Replay {
+public:
+  explicit Replay(const Options& opt) : opt_(opt) {}
+
+  int run();
+
+private:
+  const Options& opt_;
+  ClientTable clients_;
+  std::vector<std::unique_ptr<Book>> books_;
+  std::unique_ptr<AsyncLogger> log_;
+  TradeJournalReader ref_;
+  bool verifying_{false};
+
+  uint64_t commands_{0}, trades_{0}, book_rows_{0}, skipped_{0}, errors_{0};
+  uint64_t verified_{0};
+  bool mismatch_{false};
+
+  Book* find(std::string_view symbol) {
+    for (auto& b : books_)
+      if (b->symbol == symbol) return b.get();
+    return nullptr;
+  }
+  void add_symbol(const std::string& name, double tick) {
+    if (!find(name)) books_.push_back(std::make_unique<Book>(name, static_cast<uint16_t>(books_.size()), tick));
+  }
+  std::vector<JournalSymbol> journal_symbols() const;
+
+  bool setup(std::vector<std::unique_ptr<MappedFile>>& maps);
+  bool replay_file(const std::string& path, std::string_view data, uint64_t& last_seq);
+  void replay_text(const std::string& path, std::string_view data);
+  void execute(Book& b, const InputCommand& cmd, uint64_t seq);
+  void log_book(const Book& b, uint64_t seq);
+  void check(const LogRecord& rec);
+  bool check_symbols();
+};
+
+std::vector<JournalSymbol> Replay::journal_symbols() const {
+  std::vector<JournalSymbol> symbols;
+  for (const auto& b : books_) {
+    JournalSymbol js{};
+    copy_field(js.name, b->symbol);
+    js.ticks_per_unit = b->engine.scale().ticks_per_unit;
+    symbols.push_back(js);
+  }
+  return symbols;
+}
+
+static bool is_segment(std::string_view data) {
+  return data.size() >= sizeof(kInputMagic) && std::memcmp(data.data(), kInputMagic, sizeof(kInputMagic)) == 0;
+}
+
+// Maps every file and builds the symbol table before anything is written,
+// so the output journal header is complete.
+bool Replay::setup(std::vector<std::unique_ptr<MappedFile>>& maps) {
+  std::istringstream iss(opt_.symbols);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    if (item.empty()) continue;
+    auto colon = item.find(':');
+    add_symbol(item.substr(0, colon), colon == std::string::npos ? 0.01 : std::stod(item.substr(colon + 1)));
+  }
+  for (const auto& path : opt_.files) {
+    auto m = std::make_unique<MappedFile>();
+    std::string err;
+    if (!m->open(path, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return false; }
+    if (m->data().size() >= sizeof(kJournalMagic) &&
+        std::memcmp(m->data().data(), kJournalMagic, sizeof(kJournalMagic)) == 0) {
+      std::fprintf(stderr, "%s: a trade journal is output, not input (see verify=)\n", path.c_str());
+      return false;
+    }
+    if (is_segment(m->data())) {
+      InputSegmentHeader h;
+      if (!read_segment_header(m->data(), h)) {
+        std::fprintf(stderr, "%s: not a v1 input journal segment\n", path.c_str());
+        return false;
+      }
+      for (uint32_t i = 0; i < h.symbol_count; ++i) {
+        const JournalSymbol& js = h.symbols[i];
+        add_symbol(std::string(js.name, strnlen(js.name, sizeof(js.name))), 1.0 / js.ticks_per_unit);
+      }
+    }
+    maps.push_back(std::move(m));
+  }
+  if (books_.empty()) add_symbol("AUM", 0.01);
+  if (books_.size() > kJournalMaxSymbols) {
+    std::fprintf(stderr, "too many symbols (max %zu)\n", kJournalMaxSymbols);
+    return false;
+  }
+
+  if (!opt_.verify.empty()) {
+    if (!ref_.open(opt_.verify)) { std::fprintf(stderr, "%s\n", ref_.error().c_str()); return false; }
+    verifying_ = true;
+    if (!check_symbols()) mismatch_ = true;
+  }
+  if (!opt_.out.empty()) {
+    LogConfig cfg;
+    cfg.ring_capacity = 1 << 20;
+    cfg.block_when_full = true;  // a backtest must not drop records
+    cfg.flush_interval_ms = 0;
+    cfg.flush_bytes = 1 << 20;
+    log_ = std::make_unique<AsyncLogger>(cfg);
+    std::string trades = opt_.out + "_trades.bin", book = opt_.out + "_book.csv";
+    ::unlink(trades.c_str());
+    ::unlink(book.c_str());
+    if (!log_->open_journal(trades, 0, journal_symbols()) ||
+        !log_->open_book_csv(book, {"ts_ns","has_bid","bid_px","bid_qty","has_ask","ask_px","ask_qty","symbol"})) {
+      std::fprintf(stderr, "cannot create %s / %s\n", trades.c_str(), book.c_str());
+      return false;
+    }
+    log_->set_client_names(&clients_);
+    log_->start();
+  }
+  return true;
+}
+
+// the reference numbers symbols like we do, or no record can match
+bool Replay::check_symbols() {
+  const JournalHeader& h = ref_.header();
+  bool same = h.symbol_count == books_.size();
+  for (size_t i = 0; same && i < books_.size(); ++i)
+    same = std::string_view(h.symbols[i].name, strnlen(h.symbols[i].name, sizeof(h.symbols[i].name))) ==
+           books_[i]->symbol;
+  if (!same) {
+    std::printf("verify: MISMATCH symbol tables differ (reference:");
+    for (uint32_t i = 0; i < h.symbol_count; ++i)
+      std::printf(" %.*s", static_cast<int>(strnlen(h.symbols[i].name, sizeof(h.symbols[i].name))), h.symbols[i].name);
+    std::printf(", replay:");
+    for (const auto& b : books_) std::printf(" %s", b->symbol.c_str());
+    std::printf(")\n");
+  }
+  return same;
+}
+
+void Replay::execute(Book& b, const InputCommand& cmd, uint64_t seq) {
+  ++commands_;
+  switch (cmd.kind) {
+    case InputKind::NewLimit: (void)b.engine.new_limit_order(cmd.client, cmd.side, cmd.qty, cmd.px, b.fills); break;
+    case InputKind::NewMarket: (void)b.engine.new_market_order(cmd.client, cmd.side, cmd.qty, b.fills); break;
+    case InputKind::Cancel: (void)b.engine.cancel(cmd.order_id); b.fills.clear(); break;
+    case InputKind::Replace: (void)b.engine.replace(cmd.order_id, cmd.qty, cmd.px, b.fills); break;
+    case InputKind::CancelAll: (void)b.engine.cancel_all(cmd.client); b.fills.clear(); break;
+  }
+  if (!b.fills.empty()) {
+    // the same rows Server::record_trades logs, stamped with seq
+    LogRecord rec;
+    rec.kind = LogKind::Trade;
+    rec.ts_ns = seq;
+    rec.trade.symbol_id = b.id;
+    for (const Trade& tr : b.fills) {
+      rec.trade.maker_id = tr.maker_id;
+      rec.trade.taker_id = tr.taker_id;
+      rec.trade.qty = tr.qty;
+      rec.trade.px = tr.px;
+      rec.trade.maker_side = tr.maker_side;
+      rec.trade.taker_side = tr.taker_side;
+      rec.trade.maker_client = tr.maker_client;
+      rec.trade.taker_client = tr.taker_client;
+      if (log_) log_->log(rec);
+      if (verifying_) check(rec);
+    }
+    b.trades += b.fills.size();
+    trades_ += b.fills.size();
+  }
+  if (opt_.book_every && commands_ % opt_.book_every == 0) log_book(b, seq);
+}
+
+void Replay::log_book(const Book& b, uint64_t seq) {
+  ++book_rows_;
+  if (!log_) return;
+  TopOfBook top = b.engine.top();
+  const PriceScale& sc = b.engine.scale();
+  LogRecord rec;
+  rec.kind = LogKind::Book;
+  rec.ts_ns = seq;
+  copy_field(rec.symbol, b.symbol);
+  rec.book.has_bid = top.has_bid;
+  rec.book.has_ask = top.has_ask;
+  rec.book.bid_px = sc.to_px(top.bid_px);
+  rec.book.ask_px = sc.to_px(top.ask_px);
+  rec.book.bid_qty = top.bid_qty;
+  rec.book.ask_qty = top.ask_qty;
+  log_->log(rec);
+}
+
+static void print_trade(const char* who, const JournalTrade& t) {
+  std::printf("  %-9s ts=%llu maker=%llu taker=%llu qty=%d px=%lld sym=%u sides=%u/%u clients=%.*s/%.*s\n", who,
+              static_cast<unsigned long long>(t.ts_ns), static_cast<unsigned long long>(t.maker_id),
+              static_cast<unsigned long long>(t.taker_id), t.qty, static_cast<long long>(t.px), t.symbol,
+              t.maker_side, t.taker_side, static_cast<int>(strnlen(t.maker_client, sizeof(t.maker_client))),
+              t.maker_client, static_cast<int>(strnlen(t.taker_client, sizeof(t.taker_client))), t.taker_client);
+}
+
+// Compares the next trade with the reference; the first difference is
+// reported and ends the comparison (the replay itself goes on).
+void Replay::check(const LogRecord& rec) {
+  if (mismatch_) return;
+  JournalTrade got = encode_trade(rec, &clients_);
+  if (verified_ >= ref_.size()) {
+    std::printf("verify: MISMATCH replay has more trades than the reference (%zu)\n", ref_.size());
+    print_trade("replay", got);
+    mismatch_ = true;
+    return;
+  }
+  JournalTrade want = ref_[verified_];
+  if (!opt_.verify_ts) got.ts_ns = want.ts_ns = 0;
+  if (std::memcmp(&got, &want, sizeof(got)) != 0) {
+    std::printf("verify: MISMATCH at trade %llu\n", static_cast<unsigned long long>(verified_));
+    print_trade("reference", want);
+    print_trade("replay", got);
+    mismatch_ = true;
+    return;
+  }
+  ++verified_;
+}
+
+void Replay::replay_text(const std::string& path, std::string_view data) {
+  uint64_t line_no = 0;
+  std::string err;
+  InputCommand cmd;
+  while (!data.empty()) {
+    size_t nl = data.find('\n');
+    std::string_view line = trim_view(data.substr(0, nl));
+    data.remove_prefix(nl == std::string_view::npos ? data.size() : nl + 1);
+    ++line_no;
+    if (line.empty() || line[0] == '#') continue;
+
+    TokenViews toks = token_views(line);
+    std::string_view sym = take_symbol(toks);
+    if (toks.empty()) { ++skipped_; continue; }  // blank, or only "SYMBOL <name>"
+    Book* b = sym.empty() ? books_.front().get() : find(sym);
+    bool order = toks[0] == "NEW" || toks[0] == "CANCEL" || toks[0] == "REPLACE";
+    if (!order && toks[0] != "BOOK") { ++skipped_; continue; }
+    if (!b) err = "ERROR unknown symbol " + std::string(sym);
+    else if (toks[0] == "BOOK") { log_book(*b, line_no); continue; }
+    else if (parse_command(toks, clients_, cmd, err)) { execute(*b, cmd, line_no); continue; }
+
+    if (errors_++ == 0)
+      std::fprintf(stderr, "%s:%llu: %s (further errors only counted)\n", path.c_str(),
+                   static_cast<unsigned long long>(line_no), err.c_str());
+  }
+}
+
+// false when the rest of the input cannot be trusted (a journal gap)
+bool Replay::replay_file(const std::string& path, std::string_view data, uint64_t& last_seq) {
+  if (!is_segment(data)) {
+    replay_text(path, data);
+    return true;
+  }
+  InputSegmentHeader h;
+  (void)read_segment_header(data, h);
+  if (h.first_seq > last_seq + 1) {
+    std::fprintf(stderr, "%s: starts at command %llu, replayed from empty books\n", path.c_str(),
+                 static_cast<unsigned long long>(h.first_seq));
+    last_seq = h.first_seq - 1;
+  }
+  Book* b = books_.front().get();
+  bool ok = replay_segment(data, last_seq, [&](const InputCommand& logged, std::string_view symbol,
+                                               std::string_view client) {
+    if (b->symbol != symbol) b = find(symbol);  // every segment symbol was added in setup
+    InputCommand cmd = logged;
+    cmd.symbol = b->id;
+    cmd.client = clients_.intern(client);
+    execute(*b, cmd, last_seq + 1);
+  });
+  if (!ok)
+    std::fprintf(stderr, "%s: sequence gap after command %llu, stopping\n", path.c_str(),
+                 static_cast<unsigned long long>(last_seq));
+  return ok;
+}
+
+int Replay::run() {
+  std::vector<std::unique_ptr<MappedFile>> maps;
+  if (!setup(maps)) return 1;
+
+  auto t0 = Clock::now();
+  uint64_t last_seq = 0;
+  for (size_t i = 0; i < maps.size(); ++i)
+    if (!replay_file(opt_.files[i], maps[i]->data(), last_seq)) break;
+  double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  auto t1 = Clock::now();
+  if (log_) log_->stop();
+  double drain = std::chrono::duration<double>(Clock::now() - t1).count();
+
+  std::printf("replayed %llu commands in %.3f s = %.2f M commands/s, %llu trades\n",
+              static_cast<unsigned long long>(commands_), secs,
+              secs > 0 ? static_cast<double>(commands_) / secs / 1e6 : 0.0,
+              static_cast<unsigned long long>(trades_));
+  if (skipped_ || errors_)
+    std::printf("  %llu lines skipped, %llu rejected\n", static_cast<unsigned long long>(skipped_),
+                static_cast<unsigned long long>(errors_));
+  for (const auto& b : books_) {
+    TopOfBook top = b->engine.top();
+    std::printf("  %-8s %llu trades, %zu resting, next id %llu, bid %s ask %s\n", b->symbol.c_str(),
+                static_cast<unsigned long long>(b->trades), b->engine.resting_count(),
+                static_cast<unsigned long long>(b->engine.next_order_id()),
+                top.has_bid ? b->engine.scale().format(top.bid_px).c_str() : "-",
+                top.has_ask ? b->engine.scale().format(top.ask_px).c_str() : "-");
+  }
+  if (log_) {
+    LogStats s = log_->stats();
+    std::printf("  wrote %s_trades.bin + %s_book.csv: %llu records (%llu book rows), drained in %.3f s more\n",
+                opt_.out.c_str(), opt_.out.c_str(), static_cast<unsigned long long>(s.written),
+                static_cast<unsigned long long>(book_rows_), drain);
+  }
+  if (!verifying_) return 0;
+  if (!mismatch_ && verified_ < ref_.size()) {
+    std::printf("verify: MISMATCH reference has %zu trades, replay %llu\n", ref_.size(),
+                static_cast<unsigned long long>(verified_));
+    mismatch_ = true;
+  }
+  if (mismatch_) return 2;
+  std::printf("verify: OK, %llu trades identical to %s%s\n", static_cast<unsigned long long>(verified_),
+              opt_.verify.c_str(), opt_.verify_ts ? "" : " (ts_ns not compared)");
+  return 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: tradesim_replay <file>... [symbols=AUM,XYZ:0.05] [out=<prefix>] [book_every=N]\n"
+               "                       [verify=<trades.bin>] [verify_ts=0|1]\n"
+               "  file: input journal segment (state/input_*.log) or text commands, one per line\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto eq = arg.find('=');
+      if (eq == std::string::npos) { opt.files.push_back(arg); continue; }
+      std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+      if (key == "symbols") opt.symbols = val;
+      else if (key == "out") opt.out = val;
+      else if (key == "book_every") opt.book_every = std::stoull(val);
+      else if (key == "verify") opt.verify = val;
+      else if (key == "verify_ts") opt.verify_ts = val == "1";
+      else throw std::invalid_argument(arg);
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "bad argument: %s\n", e.what());
+    usage();
+    return 1;
+  }
+  if (opt.files.empty()) {
+    usage();
+    return 1;
+  }
+  Replay replay(opt);
+  return replay.run();
+}